@@ -7,11 +7,15 @@
 #include <Input/InputJayD.h>
 #include <esp_system.h>
 #include "src/InputKeys.h"
+#include "src/MixSettings.h"
 #include "src/HardwareTest.h"
 #include "src/Screens/IntroScreen/IntroScreen.h"
 #include "src/Screens/MixScreen/MixScreen.h"
 #include "src/Screens/InputTest/InputTest.h"
 #include "src/Screens/SongList/SongList.h"
+#include "src/Library/SongIndex.h"
+#include "src/Library/SongScanner.h"
+#include "src/Audio/DeckMixer.h"
 
 bool checkJig(){
 	pinMode(PIN_BL, INPUT_PULLUP);
@@ -76,6 +80,7 @@ void setup(){
 
 	Serial.println("=== INITIALIZING JAYD ===");
 	JayD.begin();
+	MixSettings.begin();
 	Serial.println("JayD initialization complete");
 	Serial.printf("Free heap after JayD.begin(): %u bytes\n", ESP.getFreeHeap());
 
@@ -104,6 +109,41 @@ void setup(){
 	digitalWrite(PIN_BL, LOW);
 }
 
+#ifdef DEBUG
+// Benchmarks and self-tests are started by hand from the serial monitor, one command per line.
+// They block the loop for a few seconds, so they stay off every user-facing path.
+void debugCommand(){
+	if(!Serial.available()) return;
+
+	String command = Serial.readStringUntil('\n');
+	command.trim();
+	if(command.length() == 0) return;
+
+	if(command == "bench index"){
+		// The benchmark writes a scratch index to the card, a running scan owns it meanwhile
+		if(Scanner.isRunning()){
+			Serial.println("Scan running, try again when it's done");
+			return;
+		}
+
+		SongIndex::benchmark();
+	}else if(command == "bench table"){
+		SongList::SongTable::benchmark();
+	}else if(command == "test swap"){
+		// The first three songs by name, the first one has to be 44.1 kHz
+		if(Scanner.isRunning() || Songs.getCount() < 3){
+			Serial.println("Needs an idle library with at least three songs");
+			return;
+		}
+
+		DeckMixer::selfTest(Songs.getPath(Songs.getSong(BY_NAME, 0)), Songs.getPath(Songs.getSong(BY_NAME, 1)),
+							Songs.getPath(Songs.getSong(BY_NAME, 2)));
+	}else{
+		Serial.printf("Unknown command \"%s\", available: bench index, bench table, test swap\n", command.c_str());
+	}
+}
+#endif
+
 uint32_t lastLoopTime = 0;
 uint32_t loopCounter = 0;
 
@@ -118,5 +158,9 @@ void loop(){
 		loopCounter++;
 	}
 	
+#ifdef DEBUG
+	debugCommand();
+#endif
+
 	LoopManager::loop();
 }
\ No newline at end of file
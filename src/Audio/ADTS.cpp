@@ -0,0 +1,79 @@
+#include "ADTS.h"
+
+const uint32_t ADTS::sampleRates[16] = {
+		96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050,
+		16000, 12000, 11025, 8000, 7350, 0, 0, 0
+};
+
+bool ADTS::parseHeader(const uint8_t* data, size_t size, ADTSHeader& header){
+	if(size < HeaderSize) return false;
+
+	// 12-bit syncword, MPEG layer must be 0
+	if(data[0] != 0xFF || (data[1] & 0xF6) != 0xF0) return false;
+
+	bool protectionAbsent = data[1] & 0x01;
+	uint8_t sfIndex = (data[2] >> 2) & 0x0F;
+	if(sampleRates[sfIndex] == 0) return false;
+
+	header.profile = ((data[2] >> 6) & 0x03) + 1;
+	header.sampleRate = sampleRates[sfIndex];
+	header.channels = ((data[2] & 0x01) << 2) | ((data[3] >> 6) & 0x03);
+	header.frameLength = ((data[3] & 0x03) << 11) | (data[4] << 3) | ((data[5] >> 5) & 0x07);
+	header.rawBlocks = (data[6] & 0x03) + 1;
+	header.headerLength = protectionAbsent ? 7 : 9;
+
+	return header.frameLength > header.headerLength;
+}
+
+int32_t ADTS::findSync(const uint8_t* data, size_t size){
+	ADTSHeader header;
+	for(size_t i = 0; i + HeaderSize <= size; i++){
+		if(data[i] != 0xFF) continue;
+		if(!parseHeader(data + i, size - i, header)) continue;
+
+		// If the next header is inside the buffer, require it to be valid too to avoid false syncs
+		size_t next = i + header.frameLength;
+		if(next + HeaderSize <= size){
+			ADTSHeader nextHeader;
+			if(!parseHeader(data + next, size - next, nextHeader)) continue;
+		}
+
+		return i;
+	}
+
+	return -1;
+}
+
+uint32_t ADTS::measure(const uint8_t* data, size_t size, ADTSHeader& first, float& frameBytes){
+	ADTSHeader header;
+	size_t cursor = 0;
+	uint32_t frames = 0;
+	uint32_t bytes = 0;
+
+	while(cursor < size && parseHeader(data + cursor, size - cursor, header)){
+		if(frames == 0){
+			first = header;
+		}
+
+		frames++;
+		bytes += header.frameLength;
+		cursor += header.frameLength;
+	}
+
+	if(frames != 0){
+		frameBytes = (float) bytes / (float) frames;
+	}
+
+	return frames;
+}
+
+uint32_t ADTS::id3Size(const uint8_t* data, size_t size){
+	if(size < 10) return 0;
+	if(data[0] != 'I' || data[1] != 'D' || data[2] != '3') return 0;
+
+	// Syncsafe integer, 7 bits per byte
+	uint32_t tagSize = ((data[6] & 0x7F) << 21) | ((data[7] & 0x7F) << 14) | ((data[8] & 0x7F) << 7) | (data[9] & 0x7F);
+	bool footer = data[5] & 0x10;
+
+	return 10 + tagSize + (footer ? 10 : 0);
+}
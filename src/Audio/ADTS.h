@@ -0,0 +1,36 @@
+#ifndef JAYD_FIRMWARE_ADTS_H
+#define JAYD_FIRMWARE_ADTS_H
+
+#include <Arduino.h>
+
+struct ADTSHeader {
+	uint32_t sampleRate = 0;
+	uint8_t channels = 0;
+	uint8_t profile = 0;
+	uint8_t headerLength = 0;
+	uint8_t rawBlocks = 0;
+	uint16_t frameLength = 0;
+};
+
+class ADTS {
+public:
+	static const uint8_t HeaderSize = 7;
+
+	// Parses a single ADTS frame header. Returns false if data doesn't start with a valid header.
+	static bool parseHeader(const uint8_t* data, size_t size, ADTSHeader& header);
+
+	// Returns the offset of the first valid ADTS header in data, or -1 if there is none.
+	static int32_t findSync(const uint8_t* data, size_t size);
+
+	// Returns the size of the ID3v2 tag at the start of data (0 if there is no tag).
+	static uint32_t id3Size(const uint8_t* data, size_t size);
+
+	// Walks the frame headers from the start of data, which must be at a sync, and averages their length.
+	// Returns the number of frames seen, first is the header of the first one.
+	static uint32_t measure(const uint8_t* data, size_t size, ADTSHeader& first, float& frameBytes);
+
+private:
+	static const uint32_t sampleRates[16];
+};
+
+#endif //JAYD_FIRMWARE_ADTS_H
@@ -0,0 +1,17 @@
+#ifndef JAYD_FIRMWARE_AUDIOFORMAT_H
+#define JAYD_FIRMWARE_AUDIOFORMAT_H
+
+// Sample format used by the DJ deck pipeline (decoder -> deck chain -> mixer -> I2S)
+#define DECK_SAMPLE_RATE 44100
+#define DECK_CHANNELS 2
+#define DECK_BYTES_PER_SAMPLE 2
+
+// Number of stereo sample frames processed per mixer block (~11.6 ms)
+#define DECK_BLOCK_SAMPLES 512
+#define DECK_BLOCK_VALUES (DECK_BLOCK_SAMPLES * DECK_CHANNELS)
+#define DECK_BLOCK_BYTES (DECK_BLOCK_VALUES * DECK_BYTES_PER_SAMPLE)
+
+// One AAC-LC frame decodes into 1024 samples per channel
+#define AAC_FRAME_SAMPLES 1024
+
+#endif //JAYD_FIRMWARE_AUDIOFORMAT_H
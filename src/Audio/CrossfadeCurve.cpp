@@ -0,0 +1,134 @@
+#include "CrossfadeCurve.h"
+
+// The toolchain is C++11, so everything below is single-expression constexpr recursion.
+namespace {
+	constexpr double pi = 3.14159265358979323846;
+
+	// Taylor series, accurate for 0 - pi/2
+	constexpr double cosSeries(double x2, double term, int n){
+		return n > 12 ? term : term + cosSeries(x2, -term * x2 / ((2 * n + 1) * (2 * n + 2)), n + 1);
+	}
+
+	constexpr double cosine(double x){
+		return cosSeries(x * x, 1.0, 0);
+	}
+
+	constexpr double newton(double x, double guess, int n){
+		return n == 0 ? guess : newton(x, 0.5 * (guess + x / guess), n - 1);
+	}
+
+	constexpr double squareRoot(double x){
+		return x <= 0 ? 0 : newton(x, x > 1 ? x : 1.0, 24);
+	}
+
+	constexpr double pow25(double x){
+		return x * x * squareRoot(x);
+	}
+
+	constexpr uint16_t toGain(double level){
+		return level <= 0 ? 0 : level >= 1 ? 256 : (uint16_t) (level * 256.0 + 0.5);
+	}
+
+	// Curves give the left deck's level for crossfader position p (0 - 1)
+
+	// Straight fade, both decks at half level in the middle
+	struct Linear {
+		static constexpr double level(double p){ return 1.0 - p; }
+	};
+
+	// Equal loudness across the whole travel: levels of both decks always square-sum to 1
+	struct ConstantPower {
+		static constexpr double level(double p){ return cosine(p * pi / 2.0); }
+	};
+
+	// Full level until the last few steps of travel, then a hard cut - for scratching
+	struct Scratch {
+		static constexpr double cutWidth = 8.0 / 255.0;
+		static constexpr double level(double p){ return p < 1.0 - cutWidth ? 1.0 : (1.0 - p) / cutWidth; }
+	};
+
+	// Both decks at full level through the center, exponential fade-out towards the far edge.
+	// This is the firmware's original crossfader response.
+	struct Smooth {
+		static constexpr double shaped(double p){
+			return p < 0.5 ? pow25(p * 2.0) * 0.5 : 0.5 + pow25((p - 0.5) * 2.0) * 0.5;
+		}
+
+		static constexpr double level(double p){
+			return shaped(p) <= 128.0 / 255.0 ? 1.0 : (1.0 - shaped(p)) * 255.0 / 128.0;
+		}
+	};
+
+	struct Table {
+		uint16_t gain[256];
+	};
+
+	template<int... I> struct Sequence {};
+	template<int N, int... I> struct MakeSequence : MakeSequence<N - 1, N - 1, I...> {};
+	template<int... I> struct MakeSequence<0, I...> { typedef Sequence<I...> type; };
+
+	template<typename Curve, int... I>
+	constexpr Table makeTable(Sequence<I...>){
+		return Table{{ toGain(Curve::level(I / 255.0))... }};
+	}
+
+	template<typename Curve>
+	constexpr Table makeTable(){
+		return makeTable<Curve>(MakeSequence<256>::type());
+	}
+
+	constexpr Table linear = makeTable<Linear>();
+	constexpr Table constantPower = makeTable<ConstantPower>();
+	constexpr Table scratch = makeTable<Scratch>();
+	constexpr Table smooth = makeTable<Smooth>();
+
+	// Compile-time checks against the reference formulas
+
+	constexpr bool fallsMonotonic(const Table& table, int i = 1){
+		return i > 255 || (table.gain[i] <= table.gain[i - 1] && fallsMonotonic(table, i + 1));
+	}
+
+	constexpr int powerError(const Table& table, int i){
+		return (int) table.gain[i] * table.gain[i] + (int) table.gain[255 - i] * table.gain[255 - i] - 65536;
+	}
+
+	constexpr bool constantPowerHolds(const Table& table, int i = 0){
+		return i > 255 || (powerError(table, i) < 1024 && powerError(table, i) > -1024 && constantPowerHolds(table, i + 1));
+	}
+
+	static_assert(linear.gain[0] == 256 && linear.gain[255] == 0 && linear.gain[128] == 127, "Linear curve endpoints");
+	static_assert(constantPower.gain[0] == 256 && constantPower.gain[255] == 0 && constantPower.gain[128] == 180,
+				  "Constant power curve doesn't match cos(p * pi / 2)");
+	static_assert(constantPowerHolds(constantPower), "Constant power curve doesn't keep L^2 + R^2 = 1");
+	static_assert(scratch.gain[246] == 256 && scratch.gain[251] == 128 && scratch.gain[255] == 0, "Scratch cut width");
+	static_assert(smooth.gain[0] == 256 && smooth.gain[141] == 256 && smooth.gain[200] == 193 && smooth.gain[255] == 0, "Smooth curve doesn't match the original crossfader response");
+	static_assert(fallsMonotonic(linear) && fallsMonotonic(constantPower) && fallsMonotonic(scratch) && fallsMonotonic(smooth),
+				  "Crossfade curves must fall monotonically");
+}
+
+const uint16_t* const CrossfadeCurve::tables[PROFILE_COUNT] = {
+		linear.gain,
+		constantPower.gain,
+		scratch.gain,
+		smooth.gain
+};
+
+const char* const CrossfadeCurve::names[PROFILE_COUNT] = {
+		"Linear",
+		"Power",
+		"Scratch",
+		"Smooth"
+};
+
+uint16_t CrossfadeCurve::gain(CrossfadeProfile profile, uint8_t channel, uint8_t position){
+	if(profile >= PROFILE_COUNT){
+		profile = SMOOTH;
+	}
+
+	return tables[profile][channel == 0 ? position : 255 - position];
+}
+
+const char* CrossfadeCurve::getName(CrossfadeProfile profile){
+	if(profile >= PROFILE_COUNT) return "";
+	return names[profile];
+}
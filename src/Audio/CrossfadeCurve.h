@@ -0,0 +1,25 @@
+#ifndef JAYD_FIRMWARE_CROSSFADECURVE_H
+#define JAYD_FIRMWARE_CROSSFADECURVE_H
+
+#include <Arduino.h>
+
+enum CrossfadeProfile : uint8_t {
+	LINEAR, CONSTANT_POWER, SCRATCH, SMOOTH, PROFILE_COUNT
+};
+
+// Crossfader gain curves, generated at compile time into 256-entry tables so the mixer
+// only does a lookup per block.
+class CrossfadeCurve {
+public:
+	// Gain of a deck in 1/256 steps (0 - 256) for crossfader position 0 - 255.
+	// Channel 1 uses the mirrored position of channel 0.
+	static uint16_t gain(CrossfadeProfile profile, uint8_t channel, uint8_t position);
+
+	static const char* getName(CrossfadeProfile profile);
+
+private:
+	static const uint16_t* const tables[PROFILE_COUNT];
+	static const char* const names[PROFILE_COUNT];
+};
+
+#endif //JAYD_FIRMWARE_CROSSFADECURVE_H
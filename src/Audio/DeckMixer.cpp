@@ -0,0 +1,733 @@
+#include "DeckMixer.h"
+#include "../Library/TrackPreloader.h"
+#include "../Library/TrackAnalyzer.h"
+#include "../Library/BeatAnalyzer.h"
+#include "../MixSettings.h"
+#include "CrossfadeCurve.h"
+#include "../Util/Hash.h"
+#include <JayD.h>
+#include <SD.h>
+#include <Settings.h>
+#include <Loop/LoopManager.h>
+#include <driver/i2s.h>
+#include <AudioLib/Effect.h>
+#include <AudioLib/InfoGenerator.h>
+#include <AudioLib/Effects/LowPass.h>
+#include <AudioLib/Effects/HighPass.h>
+#include <AudioLib/Effects/Reverb.h>
+#include <AudioLib/Effects/BitCrusher.h>
+
+const char* DeckMixer::recordPath = "/recording.wav";
+volatile uint16_t DeckMixer::load = 0;
+
+static const i2s_config_t i2sConfig = {
+		.mode = (i2s_mode_t) (I2S_MODE_MASTER | I2S_MODE_TX),
+		.sample_rate = DECK_SAMPLE_RATE,
+		.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
+		.channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
+		.communication_format = (i2s_comm_format_t) (I2S_COMM_FORMAT_I2S | I2S_COMM_FORMAT_I2S_MSB),
+		.intr_alloc_flags = 0,
+		.dma_buf_count = 4,
+		.dma_buf_len = DECK_BLOCK_SAMPLES,
+		.use_apll = false
+};
+
+DeckMixer::DeckMixer(const fs::File& f1, const fs::File& f2) : audioTask("DeckMixer", audioThread, 8 * 1024, this),
+															   requests(16, sizeof(Request)), retired(20, sizeof(Retired)){
+
+	const fs::File* files[2] = { &f1, &f2 };
+
+	for(int i = 0; i < 2; i++){
+		Deck& deck = decks[i];
+		deck.buffer = static_cast<int16_t*>(malloc(DECK_BLOCK_BYTES));
+		deck.input = static_cast<int16_t*>(malloc((DECK_BLOCK_SAMPLES + 1) * DECK_CHANNELS * DECK_BYTES_PER_SAMPLE));
+
+		if(!*files[i]) continue;
+
+		DeckSource* source = openSource(*files[i]);
+		if(!source->isValid()){
+			Serial.printf("DeckMixer: channel %d source invalid\n", i);
+			delete source;
+			continue;
+		}
+
+		deck.source = source;
+	}
+
+	mixBuffer = static_cast<int16_t*>(malloc(DECK_BLOCK_BYTES));
+	scratchBuffer = static_cast<int16_t*>(malloc(DECK_BLOCK_BYTES));
+
+	if(mixBuffer == nullptr || scratchBuffer == nullptr || decks[0].buffer == nullptr || decks[1].buffer == nullptr
+	   || decks[0].input == nullptr || decks[1].input == nullptr){
+		Serial.println("ERROR: DeckMixer buffer malloc failed");
+	}
+}
+
+DeckMixer::~DeckMixer(){
+	stop();
+
+	// Audio thread is gone, release everything still queued
+	loop(0);
+
+	Request req;
+	while(requests.receive(&req)){
+		if(req.type == Request::REPLACE){
+			delete static_cast<DeckSource*>(req.ptr);
+		}else if(req.type == Request::EFFECT){
+			delete static_cast<Effect*>(req.ptr);
+		}
+	}
+
+	for(auto& deck : decks){
+		delete deck.source;
+		for(auto effect : deck.effects){
+			delete effect;
+		}
+
+		free(deck.buffer);
+		free(deck.input);
+	}
+
+	free(mixBuffer);
+	free(scratchBuffer);
+}
+
+void DeckMixer::start(){
+	if(running) return;
+
+	i2s_driver_install(I2S_NUM_0, &i2sConfig, 0, nullptr);
+	i2s_set_pin(I2S_NUM_0, &i2s_pin_config);
+	i2s_zero_dma_buffer(I2S_NUM_0);
+
+	// Start at the current fader positions instead of ramping in from the defaults
+	CrossfadeProfile profile = (CrossfadeProfile) MixSettings.get().crossfadeCurve;
+	for(int i = 0; i < 2; i++){
+		decks[i].volume.jump(decks[i].volume.getTarget());
+		decks[i].mixGain.jump(CrossfadeCurve::gain(profile, i, mixRatio));
+	}
+
+	running = true;
+	audioTask.start(3, 0);
+	LoopManager::addListener(this);
+
+	Beats.setAudioActive(true);
+}
+
+void DeckMixer::stop(){
+	if(!running) return;
+
+	LoopManager::removeListener(this);
+
+	audioTask.stop(true);
+	running = false;
+	load = 0;
+
+	if(recording){
+		writeWavHeader(recordedBytes);
+		recordFile.close();
+		recording = false;
+	}
+
+	i2s_driver_uninstall(I2S_NUM_0);
+
+	Beats.setAudioActive(false);
+}
+
+bool DeckMixer::isRunning() const{
+	return running;
+}
+
+void DeckMixer::audioThread(Task* task){
+	DeckMixer* mixer = static_cast<DeckMixer*>(task->arg);
+
+	while(task->running){
+		uint32_t blockStart = micros();
+		mixer->processRequests();
+		mixer->mixBlock();
+
+		// Whatever is left of the block's playing time is spent waiting on DMA below
+		uint32_t blockTime = micros() - blockStart;
+		uint32_t busy = min<uint32_t>(blockTime * 100 / BlockMicros, 100);
+		load = load - load / 8 + busy;
+
+#ifdef DEBUG
+		if(blockTime > BlockMicros){
+			mixer->lateBlocks++;
+		}
+#endif
+
+		// Blocks until DMA has room, which paces the thread to the output sample rate
+		size_t written = 0;
+		i2s_write(I2S_NUM_0, mixer->mixBuffer, DECK_BLOCK_BYTES, &written, portMAX_DELAY);
+
+		if(mixer->recording){
+			mixer->recordedBytes += mixer->recordFile.write(reinterpret_cast<uint8_t*>(mixer->mixBuffer), DECK_BLOCK_BYTES);
+		}
+	}
+}
+
+void DeckMixer::request(const Request& req){
+	// Drain retired items first so the audio thread can never block on a full retire queue
+	loop(0);
+
+	if(!requests.send(&req, portMAX_DELAY)){
+		Serial.printf("DeckMixer: request %d dropped\n", req.type);
+	}
+
+	// Before start() nothing drains the queue, apply right away so callers never block on it
+	if(!running){
+		processRequests();
+	}
+}
+
+void DeckMixer::retire(Retired::Type type, void* ptr){
+	if(ptr == nullptr) return;
+
+	Retired item = { type, ptr };
+	retired.send(&item, portMAX_DELAY);
+}
+
+void DeckMixer::processRequests(){
+	Request req;
+	while(requests.receive(&req)){
+		Deck& deck = decks[req.channel & 1];
+
+		switch(req.type){
+			case Request::PAUSE:
+				deck.paused = true;
+				break;
+
+			case Request::RESUME:
+				if(deck.source != nullptr && deck.paused){
+					deck.paused = false;
+					deck.resumeRequested = req.value;
+				}
+				break;
+
+			case Request::SEEK:
+				if(deck.source != nullptr){
+					deck.source->seek(req.value);
+					deck.inputFill = 0;
+					deck.position = 0;
+				}
+				break;
+
+			case Request::REPLACE:
+				retire(Retired::SOURCE, deck.source);
+				deck.source = static_cast<DeckSource*>(req.ptr);
+				deck.paused = true;
+				deck.inputFill = 0;
+				deck.position = 0;
+				break;
+
+			case Request::EFFECT:
+				retire(Retired::EFFECT, deck.effects[req.slot]);
+				deck.effects[req.slot] = static_cast<Effect*>(req.ptr);
+
+				// A fresh effect starts at zero intensity, same as its slot on screen
+				deck.intensity[req.slot].jump(0);
+				if(deck.effects[req.slot] != nullptr){
+					deck.effects[req.slot]->setIntensity(0);
+				}
+				break;
+
+			case Request::EFFECT_INTENSITY:
+				deck.intensity[req.slot].setTarget(req.value);
+				break;
+
+			case Request::SPEED_ADD:
+				deck.speedEnabled = true;
+				deck.speed = 1.0f;
+				break;
+
+			case Request::SPEED_SET:
+				// 0 - 255 maps to 0.5x - 2x, with 128 being the original speed
+				deck.speed = pow(2.0f, ((float) req.value - 128.0f) / 128.0f);
+				break;
+
+			case Request::SPEED_RATIO:{
+				float ratio;
+				memcpy(&ratio, &req.value, sizeof(float));
+				deck.speed = ratio;
+				break;
+			}
+
+			case Request::SPEED_REMOVE:
+				deck.speedEnabled = false;
+				deck.speed = 1.0f;
+				break;
+
+			case Request::INFO:
+				if(req.channel == 2){
+					masterInfo = static_cast<InfoGenerator*>(req.ptr);
+				}else{
+					deck.info = static_cast<InfoGenerator*>(req.ptr);
+				}
+				break;
+
+			case Request::RECORD_START:
+				recordFile = SD.open(recordPath, "w");
+				if(recordFile){
+					recordedBytes = 0;
+					writeWavHeader(0);
+					recording = true;
+				}
+				break;
+
+			case Request::RECORD_STOP:
+				if(recording){
+					recording = false;
+					writeWavHeader(recordedBytes);
+					recordFile.close();
+				}
+				break;
+		}
+	}
+}
+
+void DeckMixer::renderDeck(Deck& deck){
+	DeckSource* source = deck.source;
+
+	if(deck.paused || source == nullptr){
+		memset(deck.buffer, 0, DECK_BLOCK_BYTES);
+		return;
+	}
+
+	if(deck.resumeRequested != 0){
+		deck.resumeLatency = micros() - deck.resumeRequested;
+		deck.resumeRequested = 0;
+		deck.resumeMeasured = true;
+	}
+
+	float step = (deck.speedEnabled ? deck.speed : 1.0f) * (float) source->getSampleRate() / (float) DECK_SAMPLE_RATE;
+
+	for(size_t i = 0; i < DECK_BLOCK_SAMPLES; i++){
+		size_t index = deck.position;
+
+		if(index + 1 >= deck.inputFill){
+			// Carry the last frame over so the interpolation stays continuous across refills
+			if(deck.inputFill > 0){
+				memcpy(deck.input, deck.input + (deck.inputFill - 1) * DECK_CHANNELS, DECK_CHANNELS * DECK_BYTES_PER_SAMPLE);
+				deck.position -= deck.inputFill - 1;
+				deck.inputFill = 1;
+			}
+
+			source->generate(deck.input + deck.inputFill * DECK_CHANNELS, DECK_BLOCK_SAMPLES);
+			deck.inputFill += DECK_BLOCK_SAMPLES;
+			index = deck.position;
+		}
+
+		float frac = deck.position - (float) index;
+		for(uint8_t c = 0; c < DECK_CHANNELS; c++){
+			int16_t a = deck.input[index * DECK_CHANNELS + c];
+			int16_t b = deck.input[(index + 1) * DECK_CHANNELS + c];
+			deck.buffer[i * DECK_CHANNELS + c] = a + (int16_t) ((float) (b - a) * frac);
+		}
+
+		deck.position += step;
+	}
+
+	uint16_t intensitySmoothing = MixSettings.get().intensitySmoothing;
+	for(uint8_t slot = 0; slot < 3; slot++){
+		Effect* effect = deck.effects[slot];
+		if(effect == nullptr) continue;
+
+		// Effects take one intensity per block, so the ramp moves in block-sized steps
+		SmoothedValue& intensity = deck.intensity[slot];
+		if(!intensity.isSettled()){
+			intensity.setTimeConstant(intensitySmoothing);
+			effect->setIntensity((uint8_t) roundf(intensity.step()));
+		}
+
+		effect->applyEffect(deck.buffer, scratchBuffer, DECK_BLOCK_VALUES);
+		memcpy(deck.buffer, scratchBuffer, DECK_BLOCK_BYTES);
+	}
+
+	if(source->isDone()){
+		deck.paused = true;
+	}
+}
+
+void DeckMixer::mixBlock(){
+	for(auto& deck : decks){
+		renderDeck(deck);
+
+		if(deck.info != nullptr){
+			deck.info->captureInfo(deck.buffer, DECK_BLOCK_VALUES);
+		}
+	}
+
+	// Crossfader response comes from the profile picked in settings, one table lookup per deck.
+	// The curve is applied to the raw position and the resulting gain is smoothed, so the
+	// crossfade time constant alone decides how sharp a cut can be.
+	const MixSettingsData& settings = MixSettings.get();
+	CrossfadeProfile profile = (CrossfadeProfile) settings.crossfadeCurve;
+	uint8_t ratio = mixRatio;
+
+	// Per-deck gain in Q12 (0 - 4096), ramped linearly across the block
+	int32_t gainStart[2];
+	int32_t gainDelta[2];
+	for(int i = 0; i < 2; i++){
+		Deck& deck = decks[i];
+
+		deck.mixGain.setTimeConstant(settings.crossfadeSmoothing);
+		deck.mixGain.setTarget(CrossfadeCurve::gain(profile, i, ratio));
+		deck.mixGain.step();
+
+		deck.volume.setTimeConstant(settings.volumeSmoothing);
+		deck.volume.step();
+
+		gainStart[i] = (int32_t) (deck.mixGain.getPrevious() * (deck.volume.getPrevious() + 1.0f)) >> 4;
+		gainDelta[i] = ((int32_t) (deck.mixGain.getCurrent() * (deck.volume.getCurrent() + 1.0f)) >> 4) - gainStart[i];
+	}
+
+	int32_t master = Settings.get().volumeLevel + 1;
+
+	for(size_t frame = 0; frame < DECK_BLOCK_SAMPLES; frame++){
+		int32_t gain0 = gainStart[0] + gainDelta[0] * (int32_t) frame / DECK_BLOCK_SAMPLES;
+		int32_t gain1 = gainStart[1] + gainDelta[1] * (int32_t) frame / DECK_BLOCK_SAMPLES;
+
+		for(uint8_t c = 0; c < DECK_CHANNELS; c++){
+			size_t i = frame * DECK_CHANNELS + c;
+			int32_t sample = ((int32_t) decks[0].buffer[i] * gain0 + (int32_t) decks[1].buffer[i] * gain1) >> 12;
+			sample = (sample * master) >> 8;
+			mixBuffer[i] = constrain(sample, INT16_MIN, INT16_MAX);
+		}
+	}
+
+	if(masterInfo != nullptr){
+		masterInfo->captureInfo(mixBuffer, DECK_BLOCK_VALUES);
+	}
+}
+
+uint8_t DeckMixer::getLoad(){
+	// A steady full load settles a little above 800, the rounding alone would report 101
+	return min<uint16_t>((load + 4) / 8, 100);
+}
+
+void DeckMixer::loop(uint micros){
+	Retired item;
+	while(retired.receive(&item)){
+		if(item.type == Retired::SOURCE){
+#ifdef DEBUG
+			// The old source comes back once the audio thread has swapped in the new one
+			if(replacingChannel >= 0){
+				Serial.printf("DeckMixer: channel %d replaced, %u late blocks during the swap, %u in total\n",
+							  replacingChannel, lateBlocks - replaceLateBlocks, lateBlocks);
+				replacingChannel = -1;
+			}
+#endif
+			delete static_cast<DeckSource*>(item.ptr);
+		}else{
+			delete static_cast<Effect*>(item.ptr);
+		}
+	}
+
+	for(int i = 0; i < 2; i++){
+		if(!decks[i].resumeMeasured) continue;
+		decks[i].resumeMeasured = false;
+
+		Serial.printf("DeckMixer: channel %d resumed in %u us (+%u us output buffer)\n", i, decks[i].resumeLatency, getOutputLatency());
+	}
+}
+
+DeckSource* DeckMixer::openSource(const fs::File& file){
+	// Tracks highlighted in the song list may already have their start in memory
+	TrackHead head;
+	DeckSource* source;
+	if(Preloader.take(file.name(), head)){
+		source = new DeckSource(head);
+	}else{
+		source = new DeckSource(file);
+	}
+
+	// Seek index and waveform are built in the background if the track doesn't have them yet
+	if(source->isValid()){
+		Analyzer.request(file.name());
+	}
+
+	return source;
+}
+
+bool DeckMixer::replaceChannel(uint8_t channel, fs::File file){
+	if(channel > 1) return false;
+
+#ifdef DEBUG
+	// Opening the new track competes with the running deck for the card, counted from here
+	replaceLateBlocks = lateBlocks;
+	Serial.printf("DeckMixer: replacing channel %d, %u late blocks so far\n", channel, replaceLateBlocks);
+#endif
+
+	uint32_t startTime = millis();
+	DeckSource* source = openSource(file);
+	if(!source->isValid()){
+		Serial.printf("DeckMixer: replacement for channel %d is not a valid AAC stream\n", channel);
+		delete source;
+		return false;
+	}
+
+	Serial.printf("DeckMixer: channel %d decoder ready in %u ms\n", channel, (unsigned int) (millis() - startTime));
+
+	if(!running){
+		// Nothing is reading the decks yet, swap directly
+		delete decks[channel].source;
+		decks[channel].source = source;
+		decks[channel].paused = true;
+		decks[channel].inputFill = 0;
+		decks[channel].position = 0;
+		return true;
+	}
+
+	request({ Request::REPLACE, channel, 0, 0, source });
+
+#ifdef DEBUG
+	replacingChannel = channel;
+#endif
+	return true;
+}
+
+bool DeckMixer::hasChannel(uint8_t channel) const{
+	return channel <= 1 && decks[channel].source != nullptr;
+}
+
+uint16_t DeckMixer::getDuration(uint8_t channel){
+	if(!hasChannel(channel)) return 0;
+	return decks[channel].source->getDuration();
+}
+
+uint16_t DeckMixer::getElapsed(uint8_t channel){
+	if(!hasChannel(channel)) return 0;
+	return decks[channel].source->getElapsed();
+}
+
+uint32_t DeckMixer::getElapsedSamples(uint8_t channel){
+	if(!hasChannel(channel)) return 0;
+	return decks[channel].source->getElapsedSamples();
+}
+
+uint32_t DeckMixer::getSampleRate(uint8_t channel){
+	if(!hasChannel(channel)) return DECK_SAMPLE_RATE;
+	return decks[channel].source->getSampleRate();
+}
+
+void DeckMixer::setVolume(uint8_t channel, uint8_t volume){
+	if(channel > 1) return;
+
+	if(running){
+		decks[channel].volume.setTarget(volume);
+	}else{
+		decks[channel].volume.jump(volume);
+	}
+}
+
+void DeckMixer::setMix(uint8_t ratio){
+	mixRatio = ratio;
+}
+
+Effect* DeckMixer::createEffect(EffectType type){
+	switch(type){
+		case LOWPASS:
+			return new LowPass();
+		case HIGHPASS:
+			return new HighPass();
+		case REVERB:
+			return new Reverb();
+		case BITCRUSHER:
+			return new BitCrusher();
+		default:
+			return nullptr;
+	}
+}
+
+void DeckMixer::setEffect(uint8_t channel, uint8_t slot, EffectType type){
+	if(channel > 1 || slot > 2) return;
+	request({ Request::EFFECT, channel, slot, 0, createEffect(type) });
+}
+
+void DeckMixer::setEffectIntensity(uint8_t channel, uint8_t slot, uint8_t intensity){
+	if(channel > 1 || slot > 2) return;
+	request({ Request::EFFECT_INTENSITY, channel, slot, intensity, nullptr });
+}
+
+void DeckMixer::addSpeed(uint8_t channel){
+	if(channel > 1) return;
+	request({ Request::SPEED_ADD, channel, 0, 0, nullptr });
+}
+
+void DeckMixer::setSpeed(uint8_t channel, uint8_t speed){
+	if(channel > 1) return;
+	request({ Request::SPEED_SET, channel, 0, speed, nullptr });
+}
+
+void DeckMixer::setSpeedRatio(uint8_t channel, float ratio){
+	if(channel > 1) return;
+
+	uint32_t value;
+	memcpy(&value, &ratio, sizeof(float));
+	request({ Request::SPEED_RATIO, channel, 0, value, nullptr });
+}
+
+float DeckMixer::getSpeedRatio(uint8_t channel) const{
+	if(channel > 1 || !decks[channel].speedEnabled) return 1.0f;
+	return decks[channel].speed;
+}
+
+void DeckMixer::removeSpeed(uint8_t channel){
+	if(channel > 1) return;
+	request({ Request::SPEED_REMOVE, channel, 0, 0, nullptr });
+}
+
+void DeckMixer::pauseChannel(uint8_t channel){
+	if(channel > 1) return;
+	request({ Request::PAUSE, channel, 0, 0, nullptr });
+}
+
+void DeckMixer::resumeChannel(uint8_t channel){
+	if(channel > 1) return;
+	request({ Request::RESUME, channel, 0, (uint32_t) max(micros(), 1UL), nullptr });
+}
+
+uint32_t DeckMixer::getResumeLatency(uint8_t channel) const{
+	if(channel > 1) return 0;
+	return decks[channel].resumeLatency;
+}
+
+uint32_t DeckMixer::getOutputLatency(){
+	return (uint64_t) i2sConfig.dma_buf_count * i2sConfig.dma_buf_len * 1000000 / DECK_SAMPLE_RATE;
+}
+
+bool DeckMixer::isChannelPaused(uint8_t channel){
+	if(channel > 1) return true;
+	return decks[channel].paused;
+}
+
+void DeckMixer::seekChannel(uint8_t channel, uint16_t time){
+	if(channel > 1) return;
+	request({ Request::SEEK, channel, 0, time, nullptr });
+}
+
+void DeckMixer::startRecording(){
+	request({ Request::RECORD_START, 0, 0, 0, nullptr });
+}
+
+void DeckMixer::stopRecording(){
+	request({ Request::RECORD_STOP, 0, 0, 0, nullptr });
+}
+
+bool DeckMixer::isRecording(){
+	return recording;
+}
+
+void DeckMixer::setChannelInfo(uint8_t channel, InfoGenerator* generator){
+	if(channel > 2) return;
+
+	if(!running){
+		if(channel == 2){
+			masterInfo = generator;
+		}else{
+			decks[channel].info = generator;
+		}
+		return;
+	}
+
+	request({ Request::INFO, channel, 0, 0, generator });
+}
+
+void DeckMixer::writeWavHeader(uint32_t dataSize){
+	struct {
+		char riff[4] = { 'R', 'I', 'F', 'F' };
+		uint32_t riffSize;
+		char wave[4] = { 'W', 'A', 'V', 'E' };
+		char fmt[4] = { 'f', 'm', 't', ' ' };
+		uint32_t fmtSize = 16;
+		uint16_t format = 1;
+		uint16_t channels = DECK_CHANNELS;
+		uint32_t sampleRate = DECK_SAMPLE_RATE;
+		uint32_t byteRate = DECK_SAMPLE_RATE * DECK_CHANNELS * DECK_BYTES_PER_SAMPLE;
+		uint16_t blockAlign = DECK_CHANNELS * DECK_BYTES_PER_SAMPLE;
+		uint16_t bitsPerSample = DECK_BYTES_PER_SAMPLE * 8;
+		char data[4] = { 'd', 'a', 't', 'a' };
+		uint32_t dataSize;
+	} __attribute__((packed)) header;
+
+	header.riffSize = dataSize + 36;
+	header.dataSize = dataSize;
+
+	uint32_t position = recordFile.position();
+	recordFile.seek(0);
+	recordFile.write(reinterpret_cast<uint8_t*>(&header), sizeof(header));
+	if(position > sizeof(header)){
+		recordFile.seek(position);
+	}
+}
+
+#ifdef DEBUG
+bool DeckMixer::selfTest(const char* pathA, const char* pathB, const char* pathC){
+	const uint16_t Blocks = 200;
+	const uint16_t SwapBlock = Blocks / 2;
+
+	uint32_t* reference = static_cast<uint32_t*>(ps_malloc(Blocks * sizeof(uint32_t)));
+	if(reference == nullptr) return false;
+
+	// Without start() requests are applied as they're made, deck 0 plays alone
+	{
+		DeckMixer mixer(SD.open(pathA), fs::File());
+		if(!mixer.hasChannel(0) || mixer.getSampleRate(0) != DECK_SAMPLE_RATE){
+			Serial.printf("DeckMixer self-test: %s isn't a valid %u Hz track\n", pathA, DECK_SAMPLE_RATE);
+			free(reference);
+			return false;
+		}
+
+		mixer.resumeChannel(0);
+		for(uint16_t i = 0; i < Blocks; i++){
+			mixer.mixBlock();
+			reference[i] = fnv1a(reinterpret_cast<const uint8_t*>(mixer.decks[0].buffer), DECK_BLOCK_BYTES);
+		}
+	}
+
+	DeckMixer mixer(SD.open(pathA), SD.open(pathB));
+	bool passed = mixer.hasChannel(0) && mixer.hasChannel(1);
+	mixer.resumeChannel(0);
+	mixer.resumeChannel(1);
+
+	// From here requests queue up like they do for the audio task and are applied between blocks.
+	// Nothing was started, so there's no task or I2S driver to stop.
+	mixer.running = true;
+	DeckSource* replaced = mixer.decks[1].source;
+
+	for(uint16_t i = 0; passed && i < Blocks; i++){
+		if(i == SwapBlock && !mixer.replaceChannel(1, SD.open(pathC))){
+			Serial.printf("DeckMixer self-test: couldn't open %s\n", pathC);
+			passed = false;
+			break;
+		}
+
+		uint32_t elapsed = mixer.getElapsedSamples(0);
+		mixer.processRequests();
+		mixer.mixBlock();
+		uint32_t advanced = mixer.getElapsedSamples(0) - elapsed;
+
+		// The first block decodes one refill ahead, every later one exactly a block
+		if(i > 0 && advanced != DECK_BLOCK_SAMPLES){
+			Serial.printf("DeckMixer self-test: deck 0 advanced %u samples in block %u\n", advanced, i);
+			passed = false;
+		}
+
+		if(fnv1a(reinterpret_cast<const uint8_t*>(mixer.decks[0].buffer), DECK_BLOCK_BYTES) != reference[i]){
+			Serial.printf("DeckMixer self-test: deck 0 block %u differs from the reference\n", i);
+			passed = false;
+		}
+	}
+
+	// The new source is opened while the old one is still alive, so the pointers can't match
+	if(passed && mixer.decks[1].source == replaced){
+		Serial.println("DeckMixer self-test: deck 1 was never replaced");
+		passed = false;
+	}
+	mixer.running = false;
+	free(reference);
+
+	Serial.printf("DeckMixer self-test: %s\n", passed ? "passed" : "FAILED");
+	return passed;
+}
+#endif
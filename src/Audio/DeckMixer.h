@@ -0,0 +1,184 @@
+#ifndef JAYD_FIRMWARE_DECKMIXER_H
+#define JAYD_FIRMWARE_DECKMIXER_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <Loop/LoopListener.h>
+#include <Util/Task.h>
+#include <Sync/Queue.h>
+#include <AudioLib/EffectType.hpp>
+#include "DeckSource.h"
+#include "AudioFormat.h"
+#include "SmoothedValue.h"
+
+class Effect;
+class InfoGenerator;
+
+// Two-deck DJ mixer. Each deck has its own decoder, speed stage and effect chain, and decks can
+// be replaced individually (replaceChannel) while the other deck keeps streaming.
+// The control surface mirrors the library MixSystem so MixScreen can drive it the same way.
+// All chain modifications are queued and applied by the audio thread between blocks.
+// Volume, crossfader and effect intensity calls only set targets, the audio thread ramps towards
+// them with the time constants from MixSettings so fast control moves never click.
+class DeckMixer : public LoopListener {
+public:
+	DeckMixer(const fs::File& f1, const fs::File& f2);
+	virtual ~DeckMixer();
+
+	void start();
+	void stop();
+	bool isRunning() const;
+
+	// Replaces the track on one channel. The new decoder is opened and primed on the calling
+	// thread, then swapped in between two audio blocks. The replaced channel starts paused.
+	bool replaceChannel(uint8_t channel, fs::File file);
+	bool hasChannel(uint8_t channel) const;
+
+	uint16_t getDuration(uint8_t channel);
+	uint16_t getElapsed(uint8_t channel);
+
+	void setVolume(uint8_t channel, uint8_t volume);
+	// Raw crossfader position 0 - 255, shaped by the crossfade profile from MixSettings
+	void setMix(uint8_t ratio);
+
+	void setEffect(uint8_t channel, uint8_t slot, EffectType type);
+	void setEffectIntensity(uint8_t channel, uint8_t slot, uint8_t intensity);
+
+	void addSpeed(uint8_t channel);
+	void setSpeed(uint8_t channel, uint8_t speed);
+	void removeSpeed(uint8_t channel);
+
+	// Exact playback rate for the speed stage, used by tempo sync instead of the 8-bit encoder steps
+	void setSpeedRatio(uint8_t channel, float ratio);
+	float getSpeedRatio(uint8_t channel) const;
+
+	// Source samples decoded so far and the source's own sample rate, for beat phase tracking
+	uint32_t getElapsedSamples(uint8_t channel);
+	uint32_t getSampleRate(uint8_t channel);
+
+	// Pausing freezes the deck at the exact sample: decoder, decoded-ahead frames and resampler
+	// position are kept, so resuming continues from there without a seek
+	void pauseChannel(uint8_t channel);
+	void resumeChannel(uint8_t channel);
+	bool isChannelPaused(uint8_t channel);
+
+	// Microseconds from the last resumeChannel call until its first audio block was rendered.
+	// The I2S DMA queue (getOutputLatency) adds to what's actually heard.
+	uint32_t getResumeLatency(uint8_t channel) const;
+	static uint32_t getOutputLatency();
+	void seekChannel(uint8_t channel, uint16_t time);
+
+	void startRecording();
+	void stopRecording();
+	bool isRecording();
+
+	// Channels 0 and 1 are the decks, channel 2 is the master output
+	void setChannelInfo(uint8_t channel, InfoGenerator* generator);
+
+	// Releases replaced decoders and effects outside of the audio thread
+	void loop(uint micros) override;
+
+	// Share of each block's playing time the audio thread spends decoding and mixing it, 0 - 100,
+	// smoothed over a few blocks. 0 while no mixer is running.
+	static uint8_t getLoad();
+
+	static const char* recordPath;
+
+#ifdef DEBUG
+	// Drives mixers block by block on the calling thread, without the audio task or I2S. A reference
+	// run plays track a alone on deck 0. The test run plays a next to b and replaces b with c
+	// halfway through. It passes if deck 0 renders the same samples in both runs and its source
+	// advances by exactly one block per block across the swap. a has to be a 44.1 kHz track.
+	static bool selfTest(const char* a, const char* b, const char* c);
+#endif
+
+private:
+	struct Deck {
+		DeckSource* volatile source = nullptr;
+		Effect* effects[3] = { nullptr };
+		InfoGenerator* info = nullptr;
+
+		volatile bool paused = true;
+
+		// Smoothed gain stage: fader volume (0 - 255) and crossfade curve gain (0 - 256)
+		SmoothedValue volume{ 255 };
+		SmoothedValue mixGain{ 256 };
+		SmoothedValue intensity[3];
+
+		// Resume latency instrumentation: request time in micros and time until the first rendered block
+		uint32_t resumeRequested = 0;
+		volatile uint32_t resumeLatency = 0;
+		volatile bool resumeMeasured = false;
+
+		bool speedEnabled = false;
+		volatile float speed = 1.0f;
+
+		// Linear-interpolation resampler state (speed modifier and sample rate conversion)
+		int16_t* input = nullptr;
+		size_t inputFill = 0;
+		float position = 0;
+
+		int16_t* buffer = nullptr;
+	};
+
+	struct Request {
+		enum Type : uint8_t {
+			PAUSE, RESUME, SEEK, REPLACE, EFFECT, EFFECT_INTENSITY, SPEED_ADD, SPEED_SET, SPEED_RATIO, SPEED_REMOVE,
+			INFO, RECORD_START, RECORD_STOP
+		} type;
+		uint8_t channel;
+		uint8_t slot;
+		uint32_t value;
+		void* ptr;
+	};
+
+	struct Retired {
+		enum Type : uint8_t { SOURCE, EFFECT } type;
+		void* ptr;
+	};
+
+	Deck decks[2];
+	InfoGenerator* masterInfo = nullptr;
+
+	volatile uint8_t mixRatio = 128;
+
+	int16_t* mixBuffer = nullptr;
+	int16_t* scratchBuffer = nullptr;
+
+	fs::File recordFile;
+	volatile bool recording = false;
+	uint32_t recordedBytes = 0;
+
+	Task audioTask;
+	// Average audio load in percent, times 8 so the average keeps its fraction
+	static volatile uint16_t load;
+	static const uint32_t BlockMicros = (uint64_t) DECK_BLOCK_SAMPLES * 1000000 / DECK_SAMPLE_RATE;
+
+	Queue requests;
+	Queue retired;
+	bool running = false;
+
+#ifdef DEBUG
+	// Blocks that took longer to mix than they take to play, each one eats into the DMA buffer
+	// and enough of them in a row underrun it. Logged around every replaceChannel.
+	volatile uint32_t lateBlocks = 0;
+	uint32_t replaceLateBlocks = 0;
+	int8_t replacingChannel = -1;
+#endif
+
+	DeckSource* openSource(const fs::File& file);
+
+	void request(const Request& request);
+	void processRequests();
+	void retire(Retired::Type type, void* ptr);
+
+	void renderDeck(Deck& deck);
+	void mixBlock();
+
+	void writeWavHeader(uint32_t dataSize);
+
+	static Effect* createEffect(EffectType type);
+	static void audioThread(Task* task);
+};
+
+#endif //JAYD_FIRMWARE_DECKMIXER_H
@@ -0,0 +1,291 @@
+#include "DeckSource.h"
+#include "ADTS.h"
+#include <SD.h>
+
+// The decoder opens its own handle so seeks on the caller's File never move the decoder's read position
+DeckSource::DeckSource(fs::File file, bool useSeekIndex) : file(SD.open(file.name())), useSeekIndex(useSeekIndex){
+	begin();
+}
+
+DeckSource::DeckSource(const TrackHead& head) : file(head.file), head(head.data), headSize(head.size), dataStart(head.dataStart),
+												frameBytes(head.frameBytes){
+	if(frameBytes > 0){
+		sampleRate = head.sampleRate;
+		channels = head.channels;
+	}
+
+	begin();
+}
+
+void DeckSource::begin(){
+	readBuffer = static_cast<uint8_t*>(malloc(ReadBufferSize));
+	pcm = static_cast<int16_t*>(malloc(PCMBufferSize * sizeof(int16_t)));
+	if(readBuffer == nullptr || pcm == nullptr){
+		Serial.println("ERROR: DeckSource buffer malloc failed");
+		return;
+	}
+
+	if(!file || file.size() == 0){
+		Serial.println("ERROR: DeckSource couldn't open its file");
+		return;
+	}
+
+	decoder = aacDecoder_Open(TT_MP4_ADTS, 1);
+	if(decoder == nullptr){
+		Serial.println("ERROR: AAC decoder open failed");
+		return;
+	}
+
+	aacDecoder_SetParam(decoder, AAC_PCM_MIN_OUTPUT_CHANNELS, DECK_CHANNELS);
+	aacDecoder_SetParam(decoder, AAC_PCM_MAX_OUTPUT_CHANNELS, DECK_CHANNELS);
+
+	if(frameBytes > 0){
+		// The preloader already found the stream in the head and measured its frames
+		seekData(dataStart);
+		refill();
+		dataSize = file.size() - dataStart;
+		streamMeasured();
+	}else{
+		seekData(0);
+		refill();
+
+		// Skip ID3 tags some encoders put in front of the ADTS stream
+		dataStart = ADTS::id3Size(readBuffer, readFill);
+		if(dataStart != 0){
+			seekData(dataStart);
+			resetBuffers();
+			refill();
+		}
+
+		int32_t sync = ADTS::findSync(readBuffer, readFill);
+		if(sync < 0){
+			Serial.printf("ERROR: No ADTS stream in %s\n", file.name());
+			return;
+		}
+
+		dataStart += sync;
+		readCursor = sync;
+		dataSize = file.size() - dataStart;
+
+		measureStream();
+	}
+
+	if(useSeekIndex && seekIndex.load(file)){
+		duration = ((uint64_t) seekIndex.getFrameCount() * AAC_FRAME_SAMPLES) / seekIndex.getSampleRate();
+	}
+
+	// Prime the decoder so the first block after start/resume doesn't wait on the SD card
+	valid = decodeFrame();
+}
+
+DeckSource::~DeckSource(){
+	if(decoder != nullptr){
+		aacDecoder_Close(decoder);
+	}
+
+	free(readBuffer);
+	free(pcm);
+	free(head);
+
+	file.close();
+}
+
+void DeckSource::measureStream(){
+	// Average the first frames in the read buffer to get byte rate and duration without decoding the file
+	ADTSHeader header;
+	if(ADTS::measure(readBuffer + readCursor, readFill - readCursor, header, frameBytes) == 0) return;
+
+	sampleRate = header.sampleRate;
+	channels = header.channels;
+	streamMeasured();
+}
+
+void DeckSource::streamMeasured(){
+	bitrate = frameBytes * 8.0f * (float) sampleRate / (float) AAC_FRAME_SAMPLES;
+	duration = ((float) dataSize / frameBytes) * AAC_FRAME_SAMPLES / sampleRate;
+}
+
+void DeckSource::resetBuffers(){
+	readFill = 0;
+	readCursor = 0;
+	pcmSamples = 0;
+	pcmCursor = 0;
+}
+
+bool DeckSource::refill(){
+	if(readCursor > 0){
+		memmove(readBuffer, readBuffer + readCursor, readFill - readCursor);
+		readFill -= readCursor;
+		readCursor = 0;
+	}
+
+	if(readFill >= ReadBufferSize) return true;
+
+	size_t read;
+	if(headCursor < headSize){
+		read = min(headSize - headCursor, ReadBufferSize - readFill);
+		memcpy(readBuffer + readFill, head + headCursor, read);
+		headCursor += read;
+
+		// Head used up, continue from the card right after it
+		if(headCursor >= headSize){
+			file.seek(headSize);
+		}
+	}else{
+		read = file.read(readBuffer + readFill, ReadBufferSize - readFill);
+	}
+
+	readFill += read;
+
+	return read > 0;
+}
+
+void DeckSource::seekData(uint32_t offset){
+	if(offset < headSize){
+		headCursor = offset;
+	}else{
+		headCursor = headSize;
+		file.seek(offset);
+	}
+}
+
+bool DeckSource::decodeFrame(){
+	if(decoder == nullptr) return false;
+
+	for(uint8_t attempt = 0; attempt < 16; attempt++){
+		if(readCursor < readFill){
+			UCHAR* input = readBuffer + readCursor;
+			UINT size = readFill - readCursor;
+			UINT bytesValid = size;
+			aacDecoder_Fill(decoder, &input, &size, &bytesValid);
+			readCursor = readFill - bytesValid;
+		}
+
+		AAC_DECODER_ERROR err = aacDecoder_DecodeFrame(decoder, pcm, PCMBufferSize, 0);
+
+		if(err == AAC_DEC_NOT_ENOUGH_BITS){
+			if(!refill() && readCursor >= readFill){
+				done = true;
+				return false;
+			}
+			continue;
+		}
+
+		// Corrupt frame - skip it, the transport layer resyncs on the next header
+		if(err != AAC_DEC_OK) continue;
+
+		CStreamInfo* info = aacDecoder_GetStreamInfo(decoder);
+		if(info == nullptr || info->frameSize <= 0) continue;
+
+		pcmSamples = info->frameSize;
+		pcmCursor = 0;
+		return true;
+	}
+
+	return false;
+}
+
+size_t DeckSource::generate(int16_t* outBuffer, size_t samples){
+	size_t written = 0;
+
+	while(written < samples){
+		if(pcmCursor >= pcmSamples && !decodeFrame()) break;
+
+		size_t count = min(pcmSamples - pcmCursor, samples - written);
+		memcpy(outBuffer + written * DECK_CHANNELS, pcm + pcmCursor * DECK_CHANNELS, count * DECK_CHANNELS * DECK_BYTES_PER_SAMPLE);
+
+		pcmCursor += count;
+		written += count;
+	}
+
+	if(written < samples){
+		memset(outBuffer + written * DECK_CHANNELS, 0, (samples - written) * DECK_CHANNELS * DECK_BYTES_PER_SAMPLE);
+	}
+
+	elapsedSamples += written;
+	return written;
+}
+
+void DeckSource::seek(uint16_t time){
+	seekSample((uint32_t) time * sampleRate);
+}
+
+void DeckSource::seekSample(uint32_t sample){
+	if(decoder == nullptr) return;
+
+	uint32_t frame = sample / AAC_FRAME_SAMPLES;
+
+	if(seekIndex.isLoaded()){
+		frame = min(frame, seekIndex.getFrameCount() - 1);
+
+		// AAC frames overlap their neighbours, the one in front is decoded and dropped first
+		// so the target frame comes out whole instead of fading in from a cleared decoder
+		uint32_t primed = frame > 0 ? frame - 1 : frame;
+		seekData(seekIndex.getFrameOffset(primed));
+		resetBuffers();
+		aacDecoder_SetParam(decoder, AAC_TPDEC_CLEAR_BUFFER, 1);
+
+		elapsedSamples = frame * AAC_FRAME_SAMPLES;
+		done = false;
+
+		// Decode the target frame right away and drop the samples in front of the requested one
+		if((primed == frame || decodeFrame()) && decodeFrame()){
+			uint32_t skip = min(sample - frame * AAC_FRAME_SAMPLES, (uint32_t) pcmSamples);
+			pcmCursor = skip;
+			elapsedSamples += skip;
+		}
+		return;
+	}
+
+	if(frameBytes == 0) return;
+
+	uint32_t offset = dataStart + (uint32_t) (frame * frameBytes);
+	offset = min(offset, (uint32_t) file.size());
+
+	seekData(offset);
+	resetBuffers();
+	aacDecoder_SetParam(decoder, AAC_TPDEC_CLEAR_BUFFER, 1);
+
+	elapsedSamples = frame * AAC_FRAME_SAMPLES;
+	done = false;
+}
+
+bool DeckSource::hasSeekIndex() const{
+	return seekIndex.isLoaded();
+}
+
+bool DeckSource::isValid() const{
+	return valid;
+}
+
+bool DeckSource::isDone() const{
+	return done && pcmCursor >= pcmSamples;
+}
+
+uint16_t DeckSource::getDuration() const{
+	return duration;
+}
+
+uint16_t DeckSource::getElapsed() const{
+	return elapsedSamples / sampleRate;
+}
+
+uint32_t DeckSource::getElapsedSamples() const{
+	return elapsedSamples;
+}
+
+uint32_t DeckSource::getSampleRate() const{
+	return sampleRate;
+}
+
+uint32_t DeckSource::getBitrate() const{
+	return bitrate;
+}
+
+uint8_t DeckSource::getChannels() const{
+	return channels;
+}
+
+const fs::File& DeckSource::getFile() const{
+	return file;
+}
@@ -0,0 +1,99 @@
+#ifndef JAYD_FIRMWARE_DECKSOURCE_H
+#define JAYD_FIRMWARE_DECKSOURCE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <aacdecoder_lib.h>
+#include "AudioFormat.h"
+#include "SeekIndex.h"
+
+// Start of a track that was already read into memory (see TrackPreloader). The decoder takes
+// ownership of both the open file and the PSRAM buffer.
+struct TrackHead {
+	fs::File file;
+	uint8_t* data = nullptr;
+	size_t size = 0;
+
+	// Stream layout parsed from the buffered start, so the deck skips the ID3 and sync search.
+	// frameBytes stays 0 if the stream doesn't start inside the head.
+	uint32_t dataStart = 0;
+	float frameBytes = 0;
+	uint32_t sampleRate = 0;
+	uint8_t channels = 0;
+};
+
+// AAC (ADTS) decoder for a single mixer deck. Every deck owns its own decoder instance and
+// decoded-ahead frame buffer, so a deck can be replaced without touching the other one.
+class DeckSource {
+public:
+	DeckSource(fs::File file, bool useSeekIndex = true);
+	DeckSource(const TrackHead& head);
+	virtual ~DeckSource();
+
+	bool isValid() const;
+	bool isDone() const;
+
+	// Fills outBuffer with up to DECK_BLOCK_SAMPLES interleaved stereo samples.
+	// Returns the number of sample frames written, the rest of the block is zeroed.
+	size_t generate(int16_t* outBuffer, size_t samples = DECK_BLOCK_SAMPLES);
+
+	void seek(uint16_t time);
+
+	// Sample-accurate when the track has a seek index, otherwise estimated from the average frame size
+	void seekSample(uint32_t sample);
+	bool hasSeekIndex() const;
+
+	uint16_t getDuration() const;
+	uint16_t getElapsed() const;
+	uint32_t getElapsedSamples() const;
+	uint32_t getSampleRate() const;
+	uint32_t getBitrate() const;
+	uint8_t getChannels() const;
+
+	const fs::File& getFile() const;
+
+private:
+	fs::File file;
+	HANDLE_AACDECODER decoder = nullptr;
+
+	static const size_t ReadBufferSize = 4096;
+	static const size_t PCMBufferSize = 2048 * DECK_CHANNELS;
+
+	// Preloaded start of the file, served before any SD reads
+	uint8_t* head = nullptr;
+	size_t headSize = 0;
+	size_t headCursor = 0;
+
+	uint8_t* readBuffer = nullptr;
+	size_t readFill = 0;
+	size_t readCursor = 0;
+
+	int16_t* pcm = nullptr;
+	size_t pcmSamples = 0;
+	size_t pcmCursor = 0;
+
+	uint32_t dataStart = 0;
+	uint32_t dataSize = 0;
+	float frameBytes = 0; // average ADTS frame size, used for duration and byte-offset seeking
+	SeekIndex seekIndex;
+	bool useSeekIndex = true;
+
+	volatile uint32_t elapsedSamples = 0;
+	uint32_t sampleRate = DECK_SAMPLE_RATE;
+	uint32_t bitrate = 0;
+	uint8_t channels = DECK_CHANNELS;
+	uint16_t duration = 0;
+
+	bool valid = false;
+	bool done = false;
+
+	void begin();
+	bool refill();
+	void seekData(uint32_t offset);
+	bool decodeFrame();
+	void measureStream();
+	void streamMeasured();
+	void resetBuffers();
+};
+
+#endif //JAYD_FIRMWARE_DECKSOURCE_H
@@ -0,0 +1,200 @@
+#include "SeekIndex.h"
+#include "ADTS.h"
+#include <SD.h>
+
+const char SeekIndex::Magic[4] = { 'J', 'D', 'I', 'X' };
+
+SeekIndex::SeekIndex(){
+
+}
+
+SeekIndex::~SeekIndex(){
+	unload();
+}
+
+String SeekIndex::sidecarPath(const char* trackPath){
+	String path = trackPath;
+	int dot = path.lastIndexOf('.');
+	if(dot > path.lastIndexOf('/')){
+		path = path.substring(0, dot);
+	}
+
+	return path + ".jaydidx";
+}
+
+bool SeekIndex::readHeader(fs::File& track, Header& header){
+	fs::File file = SD.open(sidecarPath(track.name()));
+	if(!file) return false;
+
+	bool ok = file.read(reinterpret_cast<uint8_t*>(&header), sizeof(Header)) == sizeof(Header)
+			  && memcmp(header.magic, Magic, sizeof(Magic)) == 0
+			  && header.version == Version
+			  && header.fileSize == track.size()
+			  && header.lastWrite == (uint32_t) track.getLastWrite()
+			  && file.size() == sizeof(Header) + header.frameCount * sizeof(uint32_t);
+
+	file.close();
+	return ok;
+}
+
+bool SeekIndex::exists(fs::File& track){
+	Header header;
+	return readHeader(track, header);
+}
+
+bool SeekIndex::load(fs::File& track){
+	unload();
+
+	Header header;
+	if(!readHeader(track, header) || header.frameCount == 0) return false;
+
+	offsets = static_cast<uint32_t*>(ps_malloc(header.frameCount * sizeof(uint32_t)));
+	if(offsets == nullptr){
+		Serial.println("ERROR: SeekIndex malloc failed");
+		return false;
+	}
+
+	fs::File file = SD.open(sidecarPath(track.name()));
+	file.seek(sizeof(Header));
+	size_t bytes = header.frameCount * sizeof(uint32_t);
+	bool ok = file.read(reinterpret_cast<uint8_t*>(offsets), bytes) == bytes;
+	file.close();
+
+	if(!ok){
+		unload();
+		return false;
+	}
+
+	frameCount = header.frameCount;
+	sampleRate = header.sampleRate;
+	return true;
+}
+
+void SeekIndex::unload(){
+	free(offsets);
+	offsets = nullptr;
+	frameCount = 0;
+}
+
+bool SeekIndex::isLoaded() const{
+	return offsets != nullptr;
+}
+
+uint32_t SeekIndex::getFrameCount() const{
+	return frameCount;
+}
+
+uint32_t SeekIndex::getSampleRate() const{
+	return sampleRate;
+}
+
+uint32_t SeekIndex::getFrameOffset(uint32_t frame) const{
+	if(frameCount == 0) return 0;
+	return offsets[min(frame, frameCount - 1)];
+}
+
+bool SeekIndex::build(fs::File& track, std::function<bool()> cancel){
+	const size_t bufferSize = 4096;
+	const size_t batchSize = 256;
+
+	uint8_t* buffer = static_cast<uint8_t*>(malloc(bufferSize));
+	uint32_t* batch = static_cast<uint32_t*>(malloc(batchSize * sizeof(uint32_t)));
+	String path = sidecarPath(track.name());
+	String tempPath = path + ".tmp";
+	fs::File out = SD.open(tempPath, FILE_WRITE);
+
+	if(buffer == nullptr || batch == nullptr || !out){
+		Serial.printf("ERROR: SeekIndex couldn't start build for %s\n", track.name());
+		free(buffer);
+		free(batch);
+		out.close();
+		return false;
+	}
+
+	Header header = {};
+	memcpy(header.magic, Magic, sizeof(Magic));
+	header.version = Version;
+	header.fileSize = track.size();
+	header.lastWrite = track.getLastWrite();
+	out.write(reinterpret_cast<uint8_t*>(&header), sizeof(Header)); // rewritten with the frame count at the end
+
+	// Skip ID3 tags in front of the stream
+	track.seek(0);
+	size_t fill = track.read(buffer, bufferSize);
+	uint32_t base = ADTS::id3Size(buffer, fill); // file offset of buffer[0]
+	size_t cursor = 0;
+	if(base != 0){
+		track.seek(base);
+		fill = 0;
+	}
+
+	size_t batched = 0;
+	bool aborted = false;
+
+	for(;;){
+		// Keep at least one whole header in the buffer
+		if(fill - cursor < ADTS::HeaderSize){
+			if(cancel && cancel()){
+				aborted = true;
+				break;
+			}
+
+			memmove(buffer, buffer + cursor, fill - cursor);
+			fill -= cursor;
+			base += cursor;
+			cursor = 0;
+			fill += track.read(buffer + fill, bufferSize - fill);
+			if(fill < ADTS::HeaderSize) break;
+		}
+
+		ADTSHeader frame;
+		if(!ADTS::parseHeader(buffer + cursor, fill - cursor, frame)){
+			// Lost sync - look for the next header, keeping a partial one at the end of the buffer
+			int32_t sync = ADTS::findSync(buffer + cursor + 1, fill - cursor - 1);
+			cursor = sync < 0 ? fill - (ADTS::HeaderSize - 1) : cursor + 1 + sync;
+			continue;
+		}
+
+		if(header.frameCount == 0){
+			header.sampleRate = frame.sampleRate;
+			header.channels = frame.channels;
+		}
+
+		batch[batched++] = base + cursor;
+		header.frameCount++;
+		if(batched == batchSize){
+			out.write(reinterpret_cast<uint8_t*>(batch), batched * sizeof(uint32_t));
+			batched = 0;
+		}
+
+		if(cursor + frame.frameLength <= fill){
+			cursor += frame.frameLength;
+		}else{
+			// Next header is past the buffer, jump there directly
+			base += cursor + frame.frameLength;
+			track.seek(base);
+			fill = 0;
+			cursor = 0;
+		}
+	}
+
+	if(batched > 0){
+		out.write(reinterpret_cast<uint8_t*>(batch), batched * sizeof(uint32_t));
+	}
+
+	out.seek(0);
+	out.write(reinterpret_cast<uint8_t*>(&header), sizeof(Header));
+	out.close();
+
+	free(buffer);
+	free(batch);
+
+	if(aborted || header.frameCount == 0){
+		SD.remove(tempPath);
+		return false;
+	}
+
+	SD.remove(path);
+	SD.rename(tempPath, path);
+	return true;
+}
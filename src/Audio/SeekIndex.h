@@ -0,0 +1,54 @@
+#ifndef JAYD_FIRMWARE_SEEKINDEX_H
+#define JAYD_FIRMWARE_SEEKINDEX_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <functional>
+
+// Byte offset of every ADTS frame of a track, stored next to it on the SD card (song.aac -> song.jaydidx).
+// Seeking with it is one file position jump to the exact frame instead of a bitrate estimate.
+// The sidecar is tied to the track's size and modification time and ignored when either changes.
+class SeekIndex {
+public:
+	SeekIndex();
+	virtual ~SeekIndex();
+
+	// Loads the sidecar of track, returns false if it's missing or stale
+	bool load(fs::File& track);
+	void unload();
+
+	bool isLoaded() const;
+	uint32_t getFrameCount() const;
+	uint32_t getSampleRate() const;
+	uint32_t getFrameOffset(uint32_t frame) const;
+
+	// Scans all ADTS headers of track and writes its sidecar. Reads the whole file, so run it
+	// from a background task. cancel is polled between reads and aborts the build when it returns true.
+	static bool build(fs::File& track, std::function<bool()> cancel = {});
+
+	static bool exists(fs::File& track);
+	static String sidecarPath(const char* trackPath);
+
+private:
+	struct Header {
+		char magic[4];
+		uint8_t version;
+		uint8_t channels;
+		uint16_t reserved;
+		uint32_t sampleRate;
+		uint32_t fileSize;
+		uint32_t lastWrite;
+		uint32_t frameCount;
+	} __attribute__((packed));
+
+	static const char Magic[4];
+	static const uint8_t Version = 1;
+
+	uint32_t* offsets = nullptr;
+	uint32_t frameCount = 0;
+	uint32_t sampleRate = 0;
+
+	static bool readHeader(fs::File& track, Header& header);
+};
+
+#endif //JAYD_FIRMWARE_SEEKINDEX_H
@@ -0,0 +1,61 @@
+#include "SmoothedValue.h"
+#include "AudioFormat.h"
+
+// Below this the remaining distance is inaudible for every parameter it's used for (0 - 255 ranges)
+static const float SettleThreshold = 0.05f;
+
+SmoothedValue::SmoothedValue(float value) : target(value), current(value), previous(value){
+
+}
+
+void SmoothedValue::setTimeConstant(uint16_t ms){
+	if(ms == timeConstant) return;
+	timeConstant = ms;
+
+	if(ms == 0){
+		coefficient = 1.0f;
+		return;
+	}
+
+	float blockMs = 1000.0f * (float) DECK_BLOCK_SAMPLES / (float) DECK_SAMPLE_RATE;
+	coefficient = 1.0f - expf(-blockMs / (float) ms);
+}
+
+void SmoothedValue::setTarget(float target){
+	this->target = target;
+}
+
+float SmoothedValue::getTarget() const{
+	return target;
+}
+
+void SmoothedValue::jump(float value){
+	target = value;
+	current = value;
+	previous = value;
+}
+
+float SmoothedValue::step(){
+	previous = current;
+
+	float distance = target - current;
+	if(fabsf(distance) < SettleThreshold){
+		current = target;
+	}else{
+		current += distance * coefficient;
+	}
+
+	return current;
+}
+
+float SmoothedValue::getPrevious() const{
+	return previous;
+}
+
+float SmoothedValue::getCurrent() const{
+	return current;
+}
+
+bool SmoothedValue::isSettled() const{
+	return current == target && previous == current;
+}
@@ -0,0 +1,39 @@
+#ifndef JAYD_FIRMWARE_SMOOTHEDVALUE_H
+#define JAYD_FIRMWARE_SMOOTHEDVALUE_H
+
+#include <Arduino.h>
+
+// Control parameter that follows its target with a one-pole lowpass, stepped once per audio block.
+// Inside a block the value is ramped linearly from the previous block's value (getPrevious) to the
+// new one (getCurrent), so a jump of the target never becomes a step in the output.
+// setTarget is the only call meant for other threads, everything else belongs to the audio thread.
+class SmoothedValue {
+public:
+	SmoothedValue(float value = 0);
+
+	// Time for the value to cover ~63% of the distance to its target. 0 jumps within one block.
+	void setTimeConstant(uint16_t ms);
+
+	void setTarget(float target);
+	float getTarget() const;
+
+	// Moves straight to value without ramping, for state that isn't audible yet
+	void jump(float value);
+
+	// Advances by one audio block, returns the new current value
+	float step();
+
+	float getPrevious() const;
+	float getCurrent() const;
+	bool isSettled() const;
+
+private:
+	volatile float target;
+	float current;
+	float previous;
+
+	uint16_t timeConstant = 0;
+	float coefficient = 1.0f;
+};
+
+#endif //JAYD_FIRMWARE_SMOOTHEDVALUE_H
@@ -0,0 +1,85 @@
+#include "TempoSync.h"
+#include "DeckMixer.h"
+
+TempoSync::TempoSync(DeckMixer* mixer) : mixer(mixer){
+
+}
+
+bool TempoSync::engage(uint8_t follower, const BeatInfo& followerBeats, const BeatInfo& masterBeats){
+	if(mixer == nullptr || follower > 1 || !followerBeats.isValid() || !masterBeats.isValid()) return false;
+
+	TempoSync::follower = follower;
+	TempoSync::followerBeats = followerBeats;
+	TempoSync::masterBeats = masterBeats;
+
+	// Master may itself be pitched, follow what's actually playing
+	float masterBPM = masterBeats.bpm * mixer->getSpeedRatio(!follower);
+	baseRatio = masterBPM / followerBeats.bpm;
+	ratio = baseRatio;
+
+	mixer->setSpeedRatio(follower, ratio);
+
+	engaged = true;
+	lastUpdate = millis();
+
+	Serial.printf("TempoSync: deck %d %.2f BPM -> %.2f BPM, ratio %.5f\n", follower, followerBeats.bpm, masterBPM, ratio);
+	return true;
+}
+
+void TempoSync::disengage(){
+	if(!engaged) return;
+
+	engaged = false;
+	Serial.printf("TempoSync: deck %d released at ratio %.5f\n", follower, ratio);
+}
+
+bool TempoSync::isEngaged() const{
+	return engaged;
+}
+
+uint8_t TempoSync::getFollower() const{
+	return follower;
+}
+
+float TempoSync::getRatio() const{
+	return ratio;
+}
+
+float TempoSync::beatPhase(uint8_t channel, const BeatInfo& beats){
+	float samplesPerBeat = 60.0f * (float) mixer->getSampleRate(channel) / beats.bpm;
+	float beat = ((float) mixer->getElapsedSamples(channel) - (float) beats.firstBeat) / samplesPerBeat;
+	return beat - floorf(beat);
+}
+
+void TempoSync::update(){
+	if(!engaged || millis() - lastUpdate < updateInterval) return;
+	lastUpdate = millis();
+
+	// Follow speed changes made on the master deck
+	baseRatio = masterBeats.bpm * mixer->getSpeedRatio(!follower) / followerBeats.bpm;
+
+	// Phase only means something while both decks move
+	if(mixer->isChannelPaused(0) || mixer->isChannelPaused(1)){
+		if(fabsf(baseRatio - ratio) >= 0.00005f){
+			ratio = baseRatio;
+			mixer->setSpeedRatio(follower, ratio);
+		}
+		return;
+	}
+
+	// Follower's phase lead in beats, wrapped to -0.5 - 0.5
+	float drift = beatPhase(follower, followerBeats) - beatPhase(!follower, masterBeats);
+	if(drift >= 0.5f) drift -= 1.0f;
+	if(drift < -0.5f) drift += 1.0f;
+
+	// Beats per second the follower has to lose (or gain) to close the gap in correctionTime
+	float followerBeatRate = followerBeats.bpm * baseRatio / 60.0f;
+	float correction = -(drift / correctionTime) / followerBeatRate;
+	correction = constrain(correction, -maxCorrection, maxCorrection);
+
+	float target = baseRatio * (1.0f + correction);
+	if(fabsf(target - ratio) < 0.00005f) return;
+
+	ratio = target;
+	mixer->setSpeedRatio(follower, ratio);
+}
@@ -0,0 +1,47 @@
+#ifndef JAYD_FIRMWARE_TEMPOSYNC_H
+#define JAYD_FIRMWARE_TEMPOSYNC_H
+
+#include <Arduino.h>
+#include "../Library/BeatAnalyzer.h"
+
+class DeckMixer;
+
+// Locks one deck (the follower) to the other deck's tempo through its speed stage. The base ratio
+// comes from the analyzed BPM of both tracks; while both decks play, the beat phase of each deck is
+// computed from its elapsed sample count and the follower's speed is nudged until the drift is gone.
+class TempoSync {
+public:
+	explicit TempoSync(DeckMixer* mixer);
+
+	bool engage(uint8_t follower, const BeatInfo& followerBeats, const BeatInfo& masterBeats);
+	void disengage();
+
+	bool isEngaged() const;
+	uint8_t getFollower() const;
+
+	// Speed ratio last applied to the follower
+	float getRatio() const;
+
+	// Call from the loop, corrects phase at most every updateInterval ms
+	void update();
+
+private:
+	DeckMixer* mixer;
+
+	bool engaged = false;
+	uint8_t follower = 0;
+	BeatInfo followerBeats;
+	BeatInfo masterBeats;
+
+	float baseRatio = 1.0f;
+	float ratio = 1.0f;
+	uint32_t lastUpdate = 0;
+
+	static const uint16_t updateInterval = 100;
+	static constexpr float correctionTime = 2.0f; // seconds to pull a phase error back in
+	static constexpr float maxCorrection = 0.03f; // largest nudge, relative to the base ratio
+
+	float beatPhase(uint8_t channel, const BeatInfo& beats);
+};
+
+#endif //JAYD_FIRMWARE_TEMPOSYNC_H
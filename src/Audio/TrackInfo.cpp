@@ -0,0 +1,66 @@
+#include "TrackInfo.h"
+#include "ADTS.h"
+#include "AudioFormat.h"
+
+static const size_t ProbeSize = 4096;
+static const uint8_t ProfileLC = 2;
+
+bool TrackInfo::isValid() const{
+	return sampleRate != 0 && duration != 0;
+}
+
+bool TrackInfo::probe(fs::File& track, TrackInfo& info){
+	info = TrackInfo();
+
+	uint8_t* buffer = static_cast<uint8_t*>(malloc(ProbeSize));
+	if(buffer == nullptr) return false;
+
+	track.seek(0);
+	size_t fill = track.read(buffer, ProbeSize);
+
+	// Skip ID3 tags some encoders put in front of the ADTS stream
+	uint32_t dataStart = ADTS::id3Size(buffer, fill);
+	if(dataStart != 0){
+		track.seek(dataStart);
+		fill = track.read(buffer, ProbeSize);
+	}
+
+	int32_t sync = ADTS::findSync(buffer, fill);
+	if(sync < 0){
+		free(buffer);
+		return false;
+	}
+
+	dataStart += sync;
+
+	ADTSHeader header;
+	size_t cursor = sync;
+	uint32_t frames = 0;
+	uint32_t bytes = 0;
+	bool supported = true;
+
+	while(cursor < fill && ADTS::parseHeader(buffer + cursor, fill - cursor, header)){
+		if(frames == 0){
+			info.sampleRate = header.sampleRate;
+			info.channels = header.channels;
+			supported = header.profile == ProfileLC;
+		}
+
+		frames++;
+		bytes += header.frameLength;
+		cursor += header.frameLength;
+	}
+
+	free(buffer);
+
+	if(frames == 0 || !supported){
+		info = TrackInfo();
+		return false;
+	}
+
+	float frameBytes = (float) bytes / (float) frames;
+	info.bitrate = frameBytes * 8.0f * (float) info.sampleRate / (float) AAC_FRAME_SAMPLES / 1000.0f + 0.5f;
+	info.duration = ((float) (track.size() - dataStart) / frameBytes) * AAC_FRAME_SAMPLES / info.sampleRate;
+
+	return info.isValid();
+}
@@ -0,0 +1,23 @@
+#ifndef JAYD_FIRMWARE_TRACKINFO_H
+#define JAYD_FIRMWARE_TRACKINFO_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+// Stream parameters of an AAC track as stored in the song index, read once from the ADTS headers
+// at the start of the file. Duration is estimated from the average frame size like DeckSource does
+// for tracks without a seek index.
+struct TrackInfo {
+	uint32_t sampleRate = 0;
+	uint16_t duration = 0; // seconds
+	uint16_t bitrate = 0; // kbit/s
+	uint8_t channels = 0;
+
+	bool isValid() const;
+
+	// Reads the first few KB of track. False for files the deck decoder can't play: no ADTS stream,
+	// or an AAC profile other than LC (HE-AAC streams signal LC in their ADTS headers).
+	static bool probe(fs::File& track, TrackInfo& info);
+} __attribute__((packed));
+
+#endif //JAYD_FIRMWARE_TRACKINFO_H
@@ -0,0 +1,339 @@
+#include "BeatAnalyzer.h"
+#include "SongScanner.h"
+#include "../Audio/DeckSource.h"
+#include "../Util/Hash.h"
+#include <SD.h>
+#include <Loop/LoopManager.h>
+#include <sys/stat.h>
+
+BeatAnalyzer Beats;
+
+const char* BeatAnalyzer::cacheFileName = "/.jayd_bpm_cache";
+const char BeatAnalyzer::Magic[4] = { 'J', 'D', 'B', 'P' };
+
+BeatAnalyzer::BeatAnalyzer() : task("BeatAnalyzer", thread, 8 * 1024, this){
+
+}
+
+void BeatAnalyzer::begin(){
+	if(task.running) return;
+
+	if(mutex == nullptr){
+		mutex = xSemaphoreCreateMutex();
+	}
+
+	if(!loaded){
+		loadCache();
+	}
+
+	// Never on core 0 - that's where the mixer renders audio. Same priority as the UI loop, which
+	// it shares the core with by time slicing and by the delays in analyze().
+	task.start(1, 1);
+	LoopManager::addListener(this);
+}
+
+void BeatAnalyzer::end(){
+	if(!task.running) return;
+
+	LoopManager::removeListener(this);
+	task.stop(true);
+	clearQueue();
+}
+
+void BeatAnalyzer::queueLibrary(SongOrder order){
+	clearQueue();
+
+	walkOrder = order;
+	walkPosition = 0;
+	walking = true;
+}
+
+void BeatAnalyzer::clearQueue(){
+	walking = false;
+	if(mutex == nullptr) return;
+
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	pending.clear();
+	xSemaphoreGive(mutex);
+}
+
+void BeatAnalyzer::loop(uint micros){
+	// Songs is only read here on the UI thread, where it's reloaded, and never while a scan is rebuilding it
+	if(!walking || mutex == nullptr || Scanner.isRunning()) return;
+
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	while(pending.size() < PendingSize && walkPosition < Songs.getCount()){
+		pending.push_back(Songs.getPath(Songs.getSong(walkOrder, walkPosition++)));
+	}
+	xSemaphoreGive(mutex);
+
+	if(walkPosition >= Songs.getCount()){
+		walking = false;
+	}
+}
+
+bool BeatAnalyzer::get(const String& path, BeatInfo& info){
+	// Only the directory entry is read, the file isn't opened
+	struct stat fileInfo;
+	if(stat((String(SongIndex::mountPoint) + path).c_str(), &fileInfo) != 0) return false;
+
+	return find(fnv1a(path.c_str()), fileInfo.st_size, fileInfo.st_mtime, info);
+}
+
+bool BeatAnalyzer::get(fs::File& track, BeatInfo& info){
+	if(!track) return false;
+
+	return find(fnv1a(track.name()), track.size(), track.getLastWrite(), info);
+}
+
+bool BeatAnalyzer::find(uint32_t pathHash, uint32_t fileSize, uint32_t lastWrite, BeatInfo& info){
+	if(mutex == nullptr) return false;
+
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	auto it = cache.find(pathHash);
+	bool found = it != cache.end() && it->second.bpm != 0
+				 && it->second.fileSize == fileSize && it->second.lastWrite == lastWrite;
+	if(found){
+		info.bpm = (float) it->second.bpm / 100.0f;
+		info.firstBeat = it->second.firstBeat;
+	}
+	xSemaphoreGive(mutex);
+
+	return found;
+}
+
+uint32_t BeatAnalyzer::getGeneration() const{
+	return generation;
+}
+
+void BeatAnalyzer::setAudioActive(bool active){
+	audioActive = active;
+}
+
+void BeatAnalyzer::loadCache(){
+	loaded = true;
+
+	fs::File file = SD.open(cacheFileName);
+	if(!file) return;
+
+	char magic[4];
+	uint8_t version;
+	if(file.read(reinterpret_cast<uint8_t*>(magic), 4) != 4 || memcmp(magic, Magic, 4) != 0
+	   || file.read(&version, 1) != 1 || version != Version){
+		Serial.println("BeatAnalyzer: cache format changed, starting over");
+		file.close();
+		SD.remove(cacheFileName);
+		return;
+	}
+
+	// Records are only ever appended, a later one for the same track replaces the earlier
+	Record record;
+	while(file.read(reinterpret_cast<uint8_t*>(&record), sizeof(Record)) == sizeof(Record)){
+		cache[record.pathHash] = record;
+	}
+	file.close();
+
+	Serial.printf("BeatAnalyzer: %d cached tracks\n", cache.size());
+}
+
+void BeatAnalyzer::store(const Record& record){
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	cache[record.pathHash] = record;
+	xSemaphoreGive(mutex);
+
+	bool created = !SD.exists(cacheFileName);
+	fs::File file = SD.open(cacheFileName, FILE_APPEND);
+	if(!file){
+		Serial.println("BeatAnalyzer: couldn't open cache file");
+		return;
+	}
+
+	if(created){
+		file.write(reinterpret_cast<const uint8_t*>(Magic), 4);
+		file.write(Version);
+	}
+
+	file.write(reinterpret_cast<const uint8_t*>(&record), sizeof(Record));
+	file.close();
+
+	generation++;
+}
+
+bool BeatAnalyzer::isCurrent(const Record& record, fs::File& track){
+	return record.fileSize == track.size() && record.lastWrite == (uint32_t) track.getLastWrite();
+}
+
+bool BeatAnalyzer::analyze(fs::File& track, BeatInfo& info){
+	info = BeatInfo();
+
+	// Undecodable tracks are stored without a tempo so they aren't retried on every pass
+	DeckSource source(track);
+	if(!source.isValid()) return true;
+
+	const uint32_t sampleRate = source.getSampleRate();
+	const float hopRate = (float) sampleRate / DECK_BLOCK_SAMPLES;
+	const uint32_t maxHops = AnalysisSeconds * hopRate;
+
+	float* onset = static_cast<float*>(ps_malloc(maxHops * sizeof(float)));
+	int16_t* block = static_cast<int16_t*>(malloc(DECK_BLOCK_BYTES));
+	if(onset == nullptr || block == nullptr){
+		free(onset);
+		free(block);
+		return false;
+	}
+
+	// Onset strength: rise in log energy of the low end, where kicks and bass carry the beat
+	const float lowpass = 1.0f - expf(-2.0f * PI * 150.0f / sampleRate);
+	float low = 0;
+	float prevEnergy = 0;
+	uint32_t hops = 0;
+
+	while(hops < maxHops && !source.isDone()){
+		if(task.isStopped()) break;
+
+		size_t samples = source.generate(block);
+		if(samples == 0) break;
+
+		float energy = 0;
+		for(size_t i = 0; i < samples; i++){
+			float mono = (float) (block[i * 2] + block[i * 2 + 1]) / 65536.0f;
+			low += lowpass * (mono - low);
+			energy += low * low;
+		}
+
+		energy = logf(1.0f + 1000.0f * energy / samples);
+		onset[hops++] = max(0.0f, energy - prevEnergy);
+		prevEnergy = energy;
+
+		// Leave the SD card and CPU to the mixer while it's running
+		if(audioActive){
+			delay(4);
+		}else if(hops % 16 == 0){
+			delay(1);
+		}
+	}
+
+	free(block);
+
+	const uint32_t minLag = floorf(hopRate * 60.0f / MaxBPM);
+	const uint32_t maxLag = ceilf(hopRate * 60.0f / MinBPM);
+
+	// Longest beat period in hops at the highest sample rate, one more for the interpolation below
+	static constexpr uint32_t MaxLag = (float) MaxSampleRate / DECK_BLOCK_SAMPLES * 60.0f / MinBPM + 1;
+	if(task.isStopped() || hops < maxLag * 8 || maxLag > MaxLag){
+		free(onset);
+		return !task.isStopped();
+	}
+
+	float mean = 0;
+	for(uint32_t i = 0; i < hops; i++){
+		mean += onset[i];
+	}
+	mean /= hops;
+	for(uint32_t i = 0; i < hops; i++){
+		onset[i] -= mean;
+	}
+
+	// Autocorrelation over the allowed tempo range, the strongest lag is the beat period
+	float corr[MaxLag + 2];
+	uint32_t bestLag = minLag;
+	for(uint32_t lag = minLag - 1; lag <= maxLag + 1; lag++){
+		if(lag % 16 == 0){
+			delay(audioActive ? 4 : 1);
+		}
+
+		float sum = 0;
+		for(uint32_t i = 0; i + lag < hops; i++){
+			sum += onset[i] * onset[i + lag];
+		}
+		corr[lag] = sum;
+
+		if(lag >= minLag && lag <= maxLag && sum > corr[bestLag]){
+			bestLag = lag;
+		}
+	}
+
+	if(corr[bestLag] <= 0){
+		free(onset);
+		return true;
+	}
+
+	// Parabolic interpolation around the peak for a fractional period
+	float y0 = corr[bestLag - 1], y1 = corr[bestLag], y2 = corr[bestLag + 1];
+	float denominator = y0 - 2.0f * y1 + y2;
+	float period = bestLag + (denominator != 0 ? 0.5f * (y0 - y2) / denominator : 0);
+
+	// Beat phase: the offset whose comb of beats lines up with the most onset energy
+	uint32_t bestPhase = 0;
+	float bestSum = -INFINITY;
+	for(uint32_t phase = 0; phase < (uint32_t) period; phase++){
+		float sum = 0;
+		for(float position = phase; position + 0.5f < hops; position += period){
+			sum += onset[(uint32_t) (position + 0.5f)];
+		}
+
+		if(sum > bestSum){
+			bestSum = sum;
+			bestPhase = phase;
+		}
+	}
+
+	free(onset);
+
+	info.bpm = 60.0f * hopRate / period;
+	info.firstBeat = bestPhase * DECK_BLOCK_SAMPLES;
+	return true;
+}
+
+void BeatAnalyzer::thread(Task* task){
+	auto analyzer = static_cast<BeatAnalyzer*>(task->arg);
+
+	while(task->running){
+		String path;
+
+		xSemaphoreTake(analyzer->mutex, portMAX_DELAY);
+		if(!analyzer->pending.empty()){
+			path = analyzer->pending.front();
+			analyzer->pending.pop_front();
+		}
+		xSemaphoreGive(analyzer->mutex);
+
+		if(path.length() == 0){
+			delay(200);
+			continue;
+		}
+
+		fs::File track = SD.open(path);
+		if(!track) continue;
+
+		Record record = {};
+		record.pathHash = fnv1a(path.c_str());
+
+		xSemaphoreTake(analyzer->mutex, portMAX_DELAY);
+		auto it = analyzer->cache.find(record.pathHash);
+		bool done = it != analyzer->cache.end() && analyzer->isCurrent(it->second, track);
+		xSemaphoreGive(analyzer->mutex);
+
+		if(done){
+			track.close();
+			continue;
+		}
+
+		uint32_t startTime = millis();
+		BeatInfo info;
+		bool analyzed = analyzer->analyze(track, info);
+
+		if(analyzed){
+			record.fileSize = track.size();
+			record.lastWrite = track.getLastWrite();
+			record.bpm = info.bpm * 100.0f + 0.5f;
+			record.firstBeat = info.firstBeat;
+			analyzer->store(record);
+
+			Serial.printf("BeatAnalyzer: %s - %.2f BPM, first beat at %u, %d ms\n", path.c_str(), info.bpm,
+						  info.firstBeat, millis() - startTime);
+		}
+
+		track.close();
+	}
+}
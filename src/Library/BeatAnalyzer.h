@@ -0,0 +1,97 @@
+#ifndef JAYD_FIRMWARE_BEATANALYZER_H
+#define JAYD_FIRMWARE_BEATANALYZER_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <Util/Task.h>
+#include <Loop/LoopListener.h>
+#include <deque>
+#include <unordered_map>
+#include "SongIndex.h"
+
+struct BeatInfo {
+	float bpm = 0;
+	uint32_t firstBeat = 0; // sample offset of the first beat, in the track's own sample rate
+
+	bool isValid() const { return bpm > 0; }
+};
+
+// Estimates tempo and first beat offset of every track in the library on its own task, pinned to the UI
+// core and throttled while the mixer is running. Results are appended to a cache file next to the song
+// index, and tracks already in it are skipped, so after a reboot the analysis picks up where it stopped.
+// The library is walked from the UI loop, which hands the task a few paths at a time.
+class BeatAnalyzer : public LoopListener {
+public:
+	BeatAnalyzer();
+
+	void begin();
+	void end();
+
+	// Starts a pass over the whole library in the given order, replacing the previous one
+	void queueLibrary(SongOrder order);
+	void clearQueue();
+
+	// Cached result for a track, false if it hasn't been analyzed yet, has no detectable tempo or the
+	// file changed since. The path version stats the file.
+	bool get(const String& path, BeatInfo& info);
+	bool get(fs::File& track, BeatInfo& info);
+
+	void loop(uint micros) override;
+
+	// Incremented every time a new result is stored
+	uint32_t getGeneration() const;
+
+	// Called by the mixer, analysis yields more often while audio is being generated
+	void setAudioActive(bool active);
+
+	static const char* cacheFileName;
+
+private:
+	struct Record {
+		uint32_t pathHash;
+		uint32_t fileSize;
+		uint32_t lastWrite;
+		uint16_t bpm; // BPM * 100, 0 if no tempo was found
+		uint32_t firstBeat;
+	} __attribute__((packed));
+
+	static const char Magic[4];
+	static const uint8_t Version = 1;
+
+	static const uint8_t AnalysisSeconds = 90;
+	static constexpr float MinBPM = 85;
+	static constexpr float MaxBPM = 170;
+
+	// Highest ADTS sample rate, sizes the autocorrelation buffer
+	static const uint32_t MaxSampleRate = 96000;
+
+	// Paths handed to the task ahead of it
+	static const uint8_t PendingSize = 8;
+
+	std::unordered_map<uint32_t, Record> cache;
+	std::deque<String> pending;
+	SongOrder walkOrder = BY_NAME;
+	uint32_t walkPosition = 0;
+	bool walking = false;
+	SemaphoreHandle_t mutex = nullptr;
+
+	Task task;
+	volatile uint32_t generation = 0;
+	volatile bool audioActive = false;
+
+	bool loaded = false;
+	void loadCache();
+	void store(const Record& record);
+
+	bool isCurrent(const Record& record, fs::File& track);
+	bool find(uint32_t pathHash, uint32_t fileSize, uint32_t lastWrite, BeatInfo& info);
+
+	// Returns false only when interrupted, a track without a detectable tempo gives an invalid info
+	bool analyze(fs::File& track, BeatInfo& info);
+
+	static void thread(Task* task);
+};
+
+extern BeatAnalyzer Beats;
+
+#endif //JAYD_FIRMWARE_BEATANALYZER_H
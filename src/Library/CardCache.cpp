@@ -0,0 +1,170 @@
+#include "CardCache.h"
+#include "../Util/Hash.h"
+#include <SD.h>
+#include <SPIFFS.h>
+
+CardCache Cards;
+
+const char* CardCache::manifestPath = "/jdsi_cards";
+
+static uint16_t read16(const uint8_t* data){
+	return data[0] | (data[1] << 8);
+}
+
+static uint32_t read32(const uint8_t* data){
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+static bool isBootRecord(const uint8_t* sector){
+	return (sector[0] == 0xEB || sector[0] == 0xE9) && read16(sector + 0x0B) == 512;
+}
+
+bool CardCache::identify(){
+	key = 0;
+
+	uint8_t* sector = static_cast<uint8_t*>(malloc(512));
+	if(sector == nullptr) return false;
+
+	// Sector 0 is the boot record on superfloppy cards, otherwise the MBR pointing at the first partition
+	bool ok = SD.readRAW(sector, 0) && sector[510] == 0x55 && sector[511] == 0xAA;
+	if(ok && !isBootRecord(sector)){
+		ok = SD.readRAW(sector, read32(sector + 0x1C6)) && isBootRecord(sector);
+	}
+
+	if(!ok){
+		Serial.println("CardCache: couldn't read the volume boot record");
+		free(sector);
+		return false;
+	}
+
+	// FAT32 has no 16-bit FAT size and keeps serial and label further in
+	bool fat32 = read16(sector + 0x16) == 0;
+	uint32_t serial = read32(sector + (fat32 ? 0x43 : 0x27));
+	char label[12] = { 0 };
+	memcpy(label, sector + (fat32 ? 0x47 : 0x2B), 11);
+	free(sector);
+
+	char identity[48];
+	snprintf(identity, sizeof(identity), "%08x %s %llu", serial, label, SD.cardSize());
+	key = fnv1a(identity);
+
+	Serial.printf("CardCache: card %s, key %08x\n", identity, key);
+	return true;
+}
+
+bool CardCache::load(SongIndex& index){
+	if(key == 0) return false;
+
+	loadManifest();
+	if(!contains()) return false;
+
+	uint32_t startTime = millis();
+	if(!index.load(SPIFFS, cachePath(key).c_str())){
+		return false;
+	}
+
+	touch(key);
+	storeManifest();
+
+	Serial.printf("CardCache: loaded %u songs for card %08x in %u ms\n", index.getCount(), key, millis() - startTime);
+	return true;
+}
+
+bool CardCache::store(const SongIndex& index){
+	if(key == 0) return false;
+
+	loadManifest();
+
+	// Make room before writing, flash is shared with the UI graphics
+	if(!contains() && keyCount == Capacity){
+		keyCount--;
+		SPIFFS.remove(cachePath(keys[keyCount]));
+		Serial.printf("CardCache: dropped card %08x\n", keys[keyCount]);
+	}
+
+	if(!index.store(SPIFFS, cachePath(key).c_str())){
+		Serial.printf("CardCache: couldn't cache card %08x, %u of %u bytes used\n", key, SPIFFS.usedBytes(), SPIFFS.totalBytes());
+		storeManifest();
+		return false;
+	}
+
+	touch(key);
+	storeManifest();
+	return true;
+}
+
+void CardCache::remove(){
+	loadManifest();
+
+	for(uint8_t i = 0; i < keyCount; i++){
+		if(keys[i] != key) continue;
+
+		SPIFFS.remove(cachePath(key));
+		memmove(keys + i, keys + i + 1, (keyCount - i - 1) * sizeof(uint32_t));
+		keyCount--;
+		storeManifest();
+
+		Serial.printf("CardCache: removed card %08x\n", key);
+		return;
+	}
+}
+
+bool CardCache::contains() const{
+	for(uint8_t i = 0; i < keyCount; i++){
+		if(keys[i] == key) return true;
+	}
+
+	return false;
+}
+
+uint32_t CardCache::getKey() const{
+	return key;
+}
+
+void CardCache::loadManifest(){
+	if(manifestLoaded) return;
+	manifestLoaded = true;
+
+	fs::File file = SPIFFS.open(manifestPath);
+	if(!file) return;
+
+	keyCount = file.read(reinterpret_cast<uint8_t*>(keys), sizeof(keys)) / sizeof(uint32_t);
+	file.close();
+}
+
+void CardCache::storeManifest(){
+	fs::File file = SPIFFS.open(manifestPath, FILE_WRITE);
+	if(!file){
+		Serial.println("CardCache: couldn't write the manifest");
+		return;
+	}
+
+	file.write(reinterpret_cast<uint8_t*>(keys), keyCount * sizeof(uint32_t));
+	file.close();
+}
+
+void CardCache::touch(uint32_t key){
+	uint8_t position = 0;
+	while(position < keyCount && keys[position] != key){
+		position++;
+	}
+
+	if(position == keyCount){
+		if(keyCount < Capacity){
+			keyCount++;
+		}
+		position = keyCount - 1;
+	}
+
+	// Shift the more recent ones down and put key in front
+	for(; position > 0; position--){
+		keys[position] = keys[position - 1];
+	}
+	keys[0] = key;
+}
+
+String CardCache::cachePath(uint32_t key){
+	char path[16];
+	snprintf(path, sizeof(path), "/jdsi_%08x", key);
+	return path;
+}
@@ -0,0 +1,51 @@
+#ifndef JAYD_FIRMWARE_CARDCACHE_H
+#define JAYD_FIRMWARE_CARDCACHE_H
+
+#include <Arduino.h>
+#include "SongIndex.h"
+
+// Copies of the song index in SPIFFS for the last few SD cards, so a card that was seen before shows
+// its library straight from flash even if its own index file is missing or couldn't be written.
+// Cards are told apart by the FAT volume serial and label plus the card size. The copy is only a
+// starting point, the background scan still checks every directory fingerprint and refreshes it.
+class CardCache {
+public:
+	// Reads the identity of the inserted card, call after SD.begin() and before load/store
+	bool identify();
+
+	// Loads the current card's copy into index and makes it the most recently used one
+	bool load(SongIndex& index);
+
+	// Writes index as the current card's copy, dropping the least recently used card when full
+	bool store(const SongIndex& index);
+
+	// Deletes the current card's copy, for a full rescan
+	void remove();
+
+	// Whether the current card has a copy, so an unchanged index still gets cached once
+	bool contains() const;
+
+	// Identity of the card read by the last identify(), 0 if it couldn't be read
+	uint32_t getKey() const;
+
+private:
+	uint32_t key = 0;
+
+	static const uint8_t Capacity = 3;
+	static const char* manifestPath;
+
+	// Card keys, most recently used first
+	uint32_t keys[Capacity] = { 0 };
+	uint8_t keyCount = 0;
+	bool manifestLoaded = false;
+
+	void loadManifest();
+	void storeManifest();
+	void touch(uint32_t key);
+
+	static String cachePath(uint32_t key);
+};
+
+extern CardCache Cards;
+
+#endif //JAYD_FIRMWARE_CARDCACHE_H
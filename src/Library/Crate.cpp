@@ -0,0 +1,143 @@
+#include "Crate.h"
+#include "SongIndex.h"
+#include "../Util/Hash.h"
+#include <SD.h>
+#include <algorithm>
+
+const char* Crate::directory = "/Crates";
+const char* Crate::extension = ".crate";
+const char Crate::Magic[4] = { 'J', 'D', 'C', 'R' };
+
+void Crate::list(std::vector<String>& names){
+	names.clear();
+
+	fs::File dir = SD.open(directory);
+	if(!dir || !dir.isDirectory()){
+		dir.close();
+		return;
+	}
+
+	for(fs::File file = dir.openNextFile(); file; file = dir.openNextFile()){
+		String name = file.name();
+		file.close();
+
+		name = name.substring(name.lastIndexOf('/') + 1);
+		if(!name.endsWith(extension) || name.startsWith(".")) continue;
+
+		names.push_back(name.substring(0, name.length() - strlen(extension)));
+	}
+	dir.close();
+
+	std::sort(names.begin(), names.end(), [](const String& a, const String& b){
+		return strcasecmp(a.c_str(), b.c_str()) < 0;
+	});
+}
+
+bool Crate::add(const String& name, const char* songPath){
+	String path = getPath(name);
+	bool exists = SD.exists(path);
+
+	if(!exists && !SD.exists(directory) && !SD.mkdir(directory)){
+		Serial.printf("Crate: couldn't create %s\n", directory);
+		return false;
+	}
+
+	fs::File file = SD.open(path, exists ? FILE_APPEND : FILE_WRITE);
+	if(!file){
+		Serial.printf("Crate: couldn't open %s\n", path.c_str());
+		return false;
+	}
+
+	bool ok = true;
+	if(!exists){
+		Header header = {};
+		memcpy(header.magic, Magic, sizeof(Magic));
+		header.version = Version;
+		ok = file.write(reinterpret_cast<uint8_t*>(&header), sizeof(Header)) == sizeof(Header);
+	}
+
+	uint32_t id = fnv1a(songPath);
+	ok = ok && file.write(reinterpret_cast<uint8_t*>(&id), sizeof(id)) == sizeof(id);
+	file.close();
+
+	Serial.printf("Crate: %s %s %s\n", ok ? "added" : "couldn't add", songPath, name.c_str());
+	return ok;
+}
+
+bool Crate::open(const String& name){
+	close();
+
+	fs::File file = SD.open(getPath(name));
+	if(!file || file.size() < sizeof(Header)){
+		file.close();
+		return false;
+	}
+
+	Header header;
+	bool ok = file.read(reinterpret_cast<uint8_t*>(&header), sizeof(Header)) == sizeof(Header)
+			  && memcmp(header.magic, Magic, sizeof(Magic)) == 0 && header.version == Version;
+
+	// A write cut short by a pulled card leaves a partial ID at the end, it's dropped here
+	uint32_t count = (file.size() - sizeof(Header)) / sizeof(uint32_t);
+	ok = ok && ids.resize(count);
+	ok = ok && file.read(reinterpret_cast<uint8_t*>(ids.data()), count * sizeof(uint32_t)) == count * sizeof(uint32_t);
+	file.close();
+
+	if(!ok){
+		Serial.printf("Crate: %s is damaged\n", name.c_str());
+		ids.clear();
+		return false;
+	}
+
+	this->name = name;
+	return true;
+}
+
+void Crate::close(){
+	name = "";
+	ids.clear();
+	position = -1;
+}
+
+bool Crate::isOpen() const{
+	return name.length() != 0;
+}
+
+const String& Crate::getName() const{
+	return name;
+}
+
+uint32_t Crate::size() const{
+	return ids.size();
+}
+
+uint32_t Crate::getId(uint32_t entry) const{
+	return ids[entry];
+}
+
+void Crate::setPosition(int32_t entry){
+	position = entry;
+}
+
+String Crate::next(){
+	while(++position < (int32_t) ids.size()){
+		int32_t song = Songs.findId(ids[position]);
+		if(song >= 0) return Songs.getPath(song);
+	}
+
+	position = ids.size();
+	return "";
+}
+
+int32_t Crate::find(const char* songPath) const{
+	uint32_t id = fnv1a(songPath);
+	for(uint32_t i = 0; i < ids.size(); i++){
+		if(ids[i] == id) return i;
+	}
+
+	return -1;
+}
+
+String Crate::getPath(const String& name){
+	return String(directory) + "/" + name + extension;
+}
@@ -0,0 +1,55 @@
+#ifndef JAYD_FIRMWARE_CRATE_H
+#define JAYD_FIRMWARE_CRATE_H
+
+#include <Arduino.h>
+#include <vector>
+#include "../Util/PSRAMVector.h"
+
+// User-ordered list of songs kept in /Crates/<name>.crate on the card. The file is a small header
+// followed by one song ID (SongIndex::getId) per entry, so adding a song during a set is a single
+// 4-byte append and opening a crate needs no directory listing, only lookups in the song index.
+class Crate {
+public:
+	// Names of the crates on the card, alphabetical
+	static void list(std::vector<String>& names);
+
+	// Appends the song to the crate, creating the crate if it doesn't exist yet
+	static bool add(const String& name, const char* songPath);
+
+	bool open(const String& name);
+	void close();
+	bool isOpen() const;
+
+	const String& getName() const;
+	uint32_t size() const;
+	uint32_t getId(uint32_t entry) const;
+
+	// Playing position for Playback. next() returns the path of the following entry that is still
+	// in the song index, an empty string after the last one. Don't call it while the scanner runs.
+	void setPosition(int32_t entry);
+	String next();
+
+	// First entry with the song, -1 if it isn't in the crate
+	int32_t find(const char* songPath) const;
+
+	static const char* directory;
+
+private:
+	String name;
+	PSRAMVector<uint32_t> ids;
+	int32_t position = -1;
+
+	struct Header {
+		char magic[4];
+		uint8_t version;
+		uint8_t reserved[3];
+	} __attribute__((packed));
+
+	static const char Magic[4];
+	static const uint8_t Version = 1;
+	static const char* extension;
+
+	static String getPath(const String& name);
+};
+
+#endif //JAYD_FIRMWARE_CRATE_H
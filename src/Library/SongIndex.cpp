@@ -0,0 +1,860 @@
+#include "SongIndex.h"
+#include "../Util/Hash.h"
+#include <SD.h>
+#include <vector>
+#include <algorithm>
+#include <dirent.h>
+#include <sys/stat.h>
+
+SongIndex Songs;
+
+const char* SongIndex::path = "/.jayd_song_index";
+const char* SongIndex::mountPoint = "/sd"; // SD.begin() default, directories are read through the VFS with it
+const char SongIndex::Magic[4] = { 'J', 'D', 'S', 'I' };
+
+// Longest full path the index keeps, FAT allows 255 characters per name but paths add up
+static const size_t MaxPathLength = 384;
+
+bool SongIndex::load(){
+	uint32_t startTime = millis();
+	if(!load(SD, path)) return false;
+
+	Serial.printf("SongIndex: loaded %u songs in %u directories in %u ms\n", songs.size(), directories.size(), millis() - startTime);
+	return true;
+}
+
+bool SongIndex::store(){
+	return store(SD, path);
+}
+
+bool SongIndex::load(fs::FS& fs, const char* path){
+	clear();
+
+	fs::File file = fs.open(path);
+	if(!file || file.isDirectory() || file.size() < sizeof(Header)){
+		file.close();
+		return false;
+	}
+
+	// One read for the whole index, parsing from memory is far quicker than many small SD reads
+	size_t size = file.size();
+	uint8_t* buffer = static_cast<uint8_t*>(ps_malloc(size));
+	if(buffer == nullptr){
+		Serial.printf("ERROR: SongIndex couldn't allocate %u bytes\n", size);
+		file.close();
+		return false;
+	}
+
+	bool ok = file.read(buffer, size) == size;
+	file.close();
+
+	Header header;
+	memcpy(&header, buffer, sizeof(Header));
+	ok = ok && memcmp(header.magic, Magic, sizeof(Magic)) == 0 && header.version == Version;
+
+	size_t cursor = sizeof(Header);
+	char fullPath[MaxPathLength + 1];
+
+	for(uint32_t d = 0; ok && d < header.directoryCount; d++){
+		DirectoryRecord record;
+		if(cursor + sizeof(DirectoryRecord) > size){
+			ok = false;
+			break;
+		}
+
+		memcpy(&record, buffer + cursor, sizeof(DirectoryRecord));
+		cursor += sizeof(DirectoryRecord);
+
+		if(cursor + record.pathLength > size || record.pathLength > MaxPathLength || record.parent >= (int32_t) d){
+			ok = false;
+			break;
+		}
+
+		memcpy(fullPath, buffer + cursor, record.pathLength);
+		fullPath[record.pathLength] = 0;
+		cursor += record.pathLength;
+
+		int32_t directory = addDirectory(fullPath, record.fingerprint, record.parent);
+		if(directory < 0){
+			ok = false;
+			break;
+		}
+
+		// Songs are stored by name only, the directory path is put back in front of them
+		size_t prefix = record.pathLength;
+		if(prefix > 1){
+			fullPath[prefix++] = '/';
+		}
+
+		for(uint16_t s = 0; s < record.songCount; s++){
+			uint32_t added;
+			TrackInfo info;
+			if(cursor + sizeof(added) + sizeof(TrackInfo) + 1 > size){
+				ok = false;
+				break;
+			}
+
+			memcpy(&added, buffer + cursor, sizeof(added));
+			cursor += sizeof(added);
+			memcpy(&info, buffer + cursor, sizeof(TrackInfo));
+			cursor += sizeof(TrackInfo);
+
+			uint8_t length = buffer[cursor++];
+			if(cursor + length > size || prefix + length > MaxPathLength){
+				ok = false;
+				break;
+			}
+
+			memcpy(fullPath + prefix, buffer + cursor, length);
+			fullPath[prefix + length] = 0;
+			cursor += length;
+
+			addedStamp = max(addedStamp, added + 1);
+
+			if(!addSong(directory, fullPath, added, info)){
+				ok = false;
+				break;
+			}
+		}
+	}
+
+	// Orderings were sorted when the index was built, they're only checked for range here
+	for(uint8_t o = 0; ok && o < ORDER_COUNT; o++){
+		size_t bytes = songs.size() * sizeof(uint32_t);
+		ok = cursor + bytes <= size && orders[o].resize(songs.size());
+		if(!ok) break;
+
+		memcpy(orders[o].data(), buffer + cursor, bytes);
+		cursor += bytes;
+
+		for(uint32_t song : orders[o]){
+			if(song >= songs.size()){
+				ok = false;
+				break;
+			}
+		}
+	}
+
+	free(buffer);
+
+	if(!ok || songs.size() != header.songCount){
+		Serial.printf("SongIndex: %s is damaged or outdated\n", path);
+		clear();
+		return false;
+	}
+
+	buildSections();
+	buildSearch();
+	buildIds();
+	return true;
+}
+
+bool SongIndex::store(fs::FS& fs, const char* path) const{
+	for(uint8_t o = 0; o < ORDER_COUNT; o++){
+		if(orders[o].size() != songs.size()){
+			Serial.println("SongIndex: orderings are incomplete, not storing the index");
+			return false;
+		}
+	}
+
+	// Written next to the old index and renamed over it, so a pulled card never leaves half an index
+	String tempPath = String(path) + ".tmp";
+	fs::File file = fs.open(tempPath, FILE_WRITE);
+	if(!file){
+		Serial.println("SongIndex: couldn't create index file");
+		return false;
+	}
+
+	Header header = {};
+	memcpy(header.magic, Magic, sizeof(Magic));
+	header.version = Version;
+	header.directoryCount = directories.size();
+	header.songCount = songs.size();
+
+	bool ok = file.write(reinterpret_cast<uint8_t*>(&header), sizeof(Header)) == sizeof(Header);
+
+	for(const Directory& directory : directories){
+		const char* directoryPath = &names[directory.path];
+
+		DirectoryRecord record;
+		record.fingerprint = directory.fingerprint;
+		record.parent = directory.parent;
+		record.pathLength = strlen(directoryPath);
+		record.songCount = directory.songCount;
+
+		ok = ok && file.write(reinterpret_cast<uint8_t*>(&record), sizeof(DirectoryRecord)) == sizeof(DirectoryRecord);
+		ok = ok && file.write(reinterpret_cast<const uint8_t*>(directoryPath), record.pathLength) == record.pathLength;
+
+		for(uint32_t i = directory.firstSong; ok && i < directory.firstSong + directory.songCount; i++){
+			const char* name = getName(i);
+			uint8_t length = strlen(name);
+
+			ok = file.write(reinterpret_cast<const uint8_t*>(&songs[i].added), sizeof(uint32_t)) == sizeof(uint32_t)
+				 && file.write(reinterpret_cast<const uint8_t*>(&songs[i].info), sizeof(TrackInfo)) == sizeof(TrackInfo)
+				 && file.write(length) == 1 && file.write(reinterpret_cast<const uint8_t*>(name), length) == length;
+		}
+	}
+
+	for(uint8_t o = 0; ok && o < ORDER_COUNT; o++){
+		size_t bytes = orders[o].size() * sizeof(uint32_t);
+		ok = orders[o].size() == songs.size() && file.write(reinterpret_cast<const uint8_t*>(orders[o].data()), bytes) == bytes;
+	}
+
+	file.close();
+
+	if(!ok){
+		Serial.println("SongIndex: writing the index failed");
+		fs.remove(tempPath);
+		return false;
+	}
+
+	fs.remove(path);
+	fs.rename(tempPath, path);
+	return true;
+}
+
+bool SongIndex::update(std::function<void(const char* path)> found, std::function<bool()> cancel){
+	uint32_t startTime = millis();
+
+	SongIndex next;
+	next.addedStamp = addedStamp;
+	next.scanDirectory("/", -1, *this, found, cancel);
+
+	if(cancel && cancel()){
+		Serial.println("SongIndex: update cancelled");
+		return false;
+	}
+
+	// Directories with songs that couldn't be opened are listed on every pass, they only count
+	// as a change once the retry turns out differently
+	bool changed = next.changedDirectories > 0 || next.directories.size() != directories.size();
+
+	// Unchanged tables come out in the same order, so the orderings carry over as they are
+	uint32_t sortTime = millis();
+	if(changed){
+		next.addedStamp++;
+		next.buildOrders();
+		next.buildSections();
+		next.buildSearch();
+		next.buildIds();
+	}else{
+		for(uint8_t o = 0; o < ORDER_COUNT; o++){
+			next.orders[o].swap(orders[o]);
+			next.sections[o].swap(sections[o]);
+		}
+		next.searchText.swap(searchText);
+		next.words.swap(words);
+		next.ids.swap(ids);
+	}
+	sortTime = millis() - sortTime;
+
+	Serial.printf("SongIndex: %u songs in %u directories, %u listed, %u taken from the index, %u unplayable, %u ms (%u ms sorting)\n",
+				  next.songs.size(), next.directories.size(), next.listedDirectories, next.reusedDirectories, next.rejectedFiles,
+				  millis() - startTime, sortTime);
+
+	swap(next);
+	return changed;
+}
+
+void SongIndex::scanDirectory(const String& path, int32_t parent, const SongIndex& previous, std::function<void(const char*)>& found,
+							  std::function<bool()>& cancel){
+	if(cancel && cancel()) return;
+
+	Fingerprint fingerprint;
+	if(!readFingerprint(path, fingerprint)) return;
+
+	int32_t index = addDirectory(path.c_str(), fingerprint, parent);
+	if(index < 0) return;
+
+	std::vector<String> subdirs;
+
+	int32_t known = previous.findDirectory(path.c_str(), directories[index].pathHash);
+	if(known >= 0 && previous.directories[known].fingerprint == fingerprint){
+		reusedDirectories++;
+
+		const Directory& directory = previous.directories[known];
+		for(uint32_t i = directory.firstSong; i < directory.firstSong + directory.songCount; i++){
+			if(addSong(index, previous.getPath(i), previous.songs[i].added, previous.songs[i].info) && found){
+				found(previous.getPath(i));
+			}
+		}
+
+		// Children always come after their parent in the table
+		for(size_t i = known + 1; i < previous.directories.size(); i++){
+			if(previous.directories[i].parent == known){
+				subdirs.push_back(&previous.names[previous.directories[i].path]);
+			}
+		}
+	}else{
+		listedDirectories++;
+
+		DIR* dir = opendir((String(mountPoint) + path).c_str());
+		if(dir == nullptr) return;
+
+		String prefix = path == "/" ? path : path + "/";
+		bool dirty = known < 0;
+
+		struct dirent* entry;
+		while((entry = readdir(dir)) != nullptr){
+			// Skip hidden files and directories (starting with . or ._)
+			if(entry->d_name[0] == '.') continue;
+
+			if(entry->d_type == DT_DIR){
+				subdirs.push_back(prefix + entry->d_name);
+				continue;
+			}
+
+			if(!isSong(entry->d_name)) continue;
+
+			// Songs already known keep their info and the pass they were first found in. New ones are
+			// probed and get this pass, files the decoder can't play never make it into the index.
+			String songPath = prefix + entry->d_name;
+			int32_t knownSong = previous.findSong(known, songPath.c_str());
+			uint32_t added = addedStamp;
+			TrackInfo info;
+
+			if(knownSong >= 0){
+				added = previous.songs[knownSong].added;
+				info = previous.songs[knownSong].info;
+			}
+
+			if(!info.isValid()){
+				fs::File file = SD.open(songPath);
+				if(!file){
+					// Not the file's fault, it's kept without info and the directory gets listed again next pass
+					Serial.printf("SongIndex: couldn't open %s, probing it next pass\n", songPath.c_str());
+					directories[index].fingerprint.entryCount = Unverified;
+				}else if(!TrackInfo::probe(file, info)){
+					file.close();
+					Serial.printf("SongIndex: skipping %s, not a playable AAC-LC stream\n", songPath.c_str());
+					rejectedFiles++;
+					dirty = true;
+					continue;
+				}else{
+					// Opened this time, the info it was kept without is filled in
+					dirty = true;
+				}
+				file.close();
+			}
+
+			// Unchanged tables reuse the previous orderings, so every song has to land where it was
+			dirty = dirty || knownSong != (int32_t) songs.size();
+
+			if(addSong(index, songPath.c_str(), added, info) && found){
+				found(songPath.c_str());
+			}
+		}
+
+		closedir(dir);
+
+		// Same songs with the same info and the same fingerprint as before means nothing to store
+		dirty = dirty || !(directories[index].fingerprint == previous.directories[known].fingerprint)
+				|| directories[index].songCount != previous.directories[known].songCount;
+		if(dirty){
+			changedDirectories++;
+		}
+	}
+
+	for(const String& subdir : subdirs){
+		scanDirectory(subdir, index, previous, found, cancel);
+	}
+}
+
+bool SongIndex::isSong(const char* name){
+	size_t length = strlen(name);
+	return length > 4 && strcasecmp(name + length - 4, ".aac") == 0;
+}
+
+bool SongIndex::readFingerprint(const String& path, Fingerprint& fingerprint){
+	String vfsPath = String(mountPoint) + path;
+
+	// readdir only walks the directory table, no entry gets opened
+	DIR* dir = opendir(vfsPath.c_str());
+	if(dir == nullptr) return false;
+
+	fingerprint.nameHash = 0;
+	fingerprint.entryCount = 0;
+
+	struct dirent* entry;
+	while((entry = readdir(dir)) != nullptr){
+		if(entry->d_name[0] == '.') continue;
+		if(entry->d_type != DT_DIR && !isSong(entry->d_name)) continue;
+
+		// Summed so the fingerprint doesn't depend on the order entries are listed in
+		fingerprint.nameHash += fnv1a(entry->d_name);
+		if(fingerprint.entryCount < Unverified - 1){
+			fingerprint.entryCount++;
+		}
+	}
+
+	closedir(dir);
+
+	// FAT keeps no timestamps for the root directory
+	struct stat info;
+	fingerprint.lastWrite = stat(vfsPath.c_str(), &info) == 0 ? info.st_mtime : 0;
+
+	return true;
+}
+
+bool SongIndex::Fingerprint::operator==(const Fingerprint& other) const{
+	return lastWrite == other.lastWrite && nameHash == other.nameHash && entryCount == other.entryCount;
+}
+
+uint32_t SongIndex::addName(const char* name, size_t length){
+	uint32_t offset = names.size();
+	names.append(name, length);
+	names.push_back(0);
+	return offset;
+}
+
+int32_t SongIndex::addDirectory(const char* path, const Fingerprint& fingerprint, int32_t parent){
+	if(directories.size() >= UINT16_MAX) return -1;
+
+	Directory directory;
+	directory.path = addName(path, strlen(path));
+	directory.pathHash = fnv1a(path);
+	directory.fingerprint = fingerprint;
+	directory.parent = parent;
+	directory.firstSong = songs.size();
+	directory.songCount = 0;
+
+	if(!directories.push_back(directory)) return -1;
+	return directories.size() - 1;
+}
+
+bool SongIndex::addSong(uint16_t directory, const char* path, uint32_t added, const TrackInfo& info){
+	size_t length = strlen(path);
+	const char* slash = strrchr(path, '/');
+	uint16_t name = slash == nullptr ? 0 : slash - path + 1;
+
+	// Entries store the name length in a byte
+	if(length > MaxPathLength || length - name > UINT8_MAX) return false;
+
+	Song song;
+	song.path = addName(path, length);
+	song.name = name;
+	song.directory = directory;
+	song.added = added;
+	song.info = info;
+
+	if(!songs.push_back(song)) return false;
+
+	directories[directory].songCount++;
+	return true;
+}
+
+int32_t SongIndex::findSong(int32_t directory, const char* path) const{
+	if(directory < 0) return -1;
+
+	const Directory& record = directories[directory];
+	for(uint32_t i = record.firstSong; i < record.firstSong + record.songCount; i++){
+		if(strcmp(getPath(i), path) == 0) return i;
+	}
+
+	return -1;
+}
+
+int32_t SongIndex::findDirectory(const char* path, uint32_t hash) const{
+	for(size_t i = 0; i < directories.size(); i++){
+		if(directories[i].pathHash == hash && strcmp(&names[directories[i].path], path) == 0){
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void SongIndex::swap(SongIndex& other){
+	directories.swap(other.directories);
+	songs.swap(other.songs);
+	names.swap(other.names);
+	for(uint8_t o = 0; o < ORDER_COUNT; o++){
+		orders[o].swap(other.orders[o]);
+		sections[o].swap(other.sections[o]);
+	}
+	searchText.swap(other.searchText);
+	words.swap(other.words);
+	ids.swap(other.ids);
+	std::swap(addedStamp, other.addedStamp);
+	std::swap(listedDirectories, other.listedDirectories);
+	std::swap(rejectedFiles, other.rejectedFiles);
+	std::swap(reusedDirectories, other.reusedDirectories);
+}
+
+void SongIndex::clear(){
+	directories.clear();
+	songs.clear();
+	names.clear();
+	for(uint8_t o = 0; o < ORDER_COUNT; o++){
+		orders[o].clear();
+		sections[o].clear();
+	}
+	searchText.clear();
+	words.clear();
+	ids.clear();
+	addedStamp = 1;
+}
+
+void SongIndex::remove(){
+	if(SD.exists(path)){
+		SD.remove(path);
+		Serial.println("SongIndex: removed stored index");
+	}
+}
+
+uint32_t SongIndex::getCount() const{
+	return songs.size();
+}
+
+const char* SongIndex::getPath(uint32_t song) const{
+	return &names[songs[song].path];
+}
+
+const char* SongIndex::getName(uint32_t song) const{
+	return &names[songs[song].path + songs[song].name];
+}
+
+const TrackInfo& SongIndex::getInfo(uint32_t song) const{
+	return songs[song].info;
+}
+
+int32_t SongIndex::find(const char* path) const{
+	const char* slash = strrchr(path, '/');
+	if(slash == nullptr) return -1;
+
+	String directory = slash == path ? String("/") : String(path).substring(0, slash - path);
+	return findSong(findDirectory(directory.c_str(), fnv1a(directory.c_str())), path);
+}
+
+uint32_t SongIndex::getDirectoryCount() const{
+	return directories.size();
+}
+
+uint32_t SongIndex::getSong(SongOrder order, uint32_t position) const{
+	if(order >= ORDER_COUNT || orders[order].size() != songs.size()) return position;
+	return orders[order][position];
+}
+
+uint32_t SongIndex::getSectionCount(SongOrder order) const{
+	return order < ORDER_COUNT ? sections[order].size() : 0;
+}
+
+const SongIndex::Section& SongIndex::getSection(SongOrder order, uint32_t section) const{
+	return sections[order][section];
+}
+
+const char* SongIndex::getOrderName(SongOrder order){
+	static const char* names[ORDER_COUNT] = { "Name", "Folder", "Artist", "Recent" };
+	return order < ORDER_COUNT ? names[order] : "";
+}
+
+void SongIndex::dropOrders(){
+	// Out of memory halfway through. Half-filled orderings would point anywhere, empty ones make
+	// getSong() fall back to the table order and keep store() from writing them.
+	Serial.println("SongIndex: out of memory sorting, songs stay in table order");
+	for(auto& order : orders){
+		order.clear();
+	}
+}
+
+void SongIndex::collationKey(const char* text, char* key, size_t keySize){
+	const char* extension = strrchr(text, '.');
+	size_t length = 0;
+	bool separator = false;
+
+	for(const char* c = text; *c && c != extension && length < keySize; c++){
+		uint8_t ch = *c;
+
+		if(isalnum(ch) || ch >= 0x80){
+			if(separator && length > 0 && length < keySize - 1){
+				key[length++] = ' ';
+			}
+			separator = false;
+			key[length++] = tolower(ch);
+		}else{
+			separator = true;
+		}
+	}
+
+	memset(key + length, 0, keySize - length);
+}
+
+void SongIndex::buildOrders(){
+	uint32_t count = songs.size();
+	for(auto& order : orders){
+		order.resize(count);
+	}
+
+	// Keys are computed once per song here, comparisons are plain memcmp on them
+	PSRAMVector<char> keys;
+	if(!keys.resize(count * KeySize)){
+		dropOrders();
+		return;
+	}
+	const char* keyData = keys.data();
+
+	auto byKey = [keyData](uint32_t a, uint32_t b){
+		int diff = memcmp(keyData + a * KeySize, keyData + b * KeySize, KeySize);
+		return diff != 0 ? diff < 0 : a < b;
+	};
+
+	for(uint32_t i = 0; i < count; i++){
+		collationKey(getName(i), &keys[i * KeySize], KeySize);
+		orders[BY_NAME][i] = i;
+	}
+	std::sort(orders[BY_NAME].begin(), orders[BY_NAME].end(), byKey);
+
+	PSRAMVector<uint32_t> nameRank;
+	if(!nameRank.resize(count)){
+		dropOrders();
+		return;
+	}
+	for(uint32_t position = 0; position < count; position++){
+		nameRank[orders[BY_NAME][position]] = position;
+	}
+	const uint32_t* rank = nameRank.data();
+
+	// Artist is the part after the last " - " of "Title - Artist", songs without one go last
+	for(uint32_t i = 0; i < count; i++){
+		const char* artist = findArtist(getName(i));
+		if(artist != nullptr){
+			collationKey(artist, &keys[i * KeySize], KeySize);
+		}else{
+			memset(&keys[i * KeySize], 0xFF, KeySize);
+		}
+		orders[BY_ARTIST][i] = i;
+	}
+	std::sort(orders[BY_ARTIST].begin(), orders[BY_ARTIST].end(), [keyData, rank](uint32_t a, uint32_t b){
+		int diff = memcmp(keyData + a * KeySize, keyData + b * KeySize, KeySize);
+		return diff != 0 ? diff < 0 : rank[a] < rank[b];
+	});
+
+	// Folders by their full path, songs inside a folder by name
+	PSRAMVector<uint32_t> directoryOrder;
+	PSRAMVector<uint32_t> directoryRank;
+	if(!directoryOrder.resize(directories.size()) || !directoryRank.resize(directories.size())){
+		dropOrders();
+		return;
+	}
+	for(uint32_t d = 0; d < directories.size(); d++){
+		directoryOrder[d] = d;
+	}
+	std::sort(directoryOrder.begin(), directoryOrder.end(), [this](uint32_t a, uint32_t b){
+		return strcasecmp(&names[directories[a].path], &names[directories[b].path]) < 0;
+	});
+	for(uint32_t position = 0; position < directories.size(); position++){
+		directoryRank[directoryOrder[position]] = position;
+	}
+	const uint32_t* folderRank = directoryRank.data();
+	const Song* songData = songs.data();
+
+	for(uint32_t i = 0; i < count; i++){
+		orders[BY_FOLDER][i] = i;
+		orders[BY_ADDED][i] = i;
+	}
+	std::sort(orders[BY_FOLDER].begin(), orders[BY_FOLDER].end(), [songData, folderRank, rank](uint32_t a, uint32_t b){
+		uint32_t folderA = folderRank[songData[a].directory];
+		uint32_t folderB = folderRank[songData[b].directory];
+		return folderA != folderB ? folderA < folderB : rank[a] < rank[b];
+	});
+
+	// Newest first
+	std::sort(orders[BY_ADDED].begin(), orders[BY_ADDED].end(), [songData, rank](uint32_t a, uint32_t b){
+		return songData[a].added != songData[b].added ? songData[a].added > songData[b].added : rank[a] < rank[b];
+	});
+}
+
+void SongIndex::buildSections(){
+	for(uint8_t o = 0; o < ORDER_COUNT; o++){
+		sections[o].clear();
+		if(orders[o].size() != songs.size()) continue;
+
+		uint32_t previous = UINT32_MAX;
+		for(uint32_t position = 0; position < songs.size(); position++){
+			const Song& song = songs[orders[o][position]];
+			uint32_t marker;
+			char letter;
+
+			if(o == BY_FOLDER){
+				const char* path = &names[directories[song.directory].path];
+				const char* slash = strrchr(path, '/');
+				letter = sectionLetter(slash != nullptr ? slash + 1 : path);
+				marker = song.directory;
+			}else if(o == BY_ADDED){
+				letter = '+';
+				marker = song.added;
+			}else{
+				const char* name = &names[song.path + song.name];
+				const char* text = o == BY_ARTIST ? findArtist(name) : name;
+				letter = text != nullptr ? sectionLetter(text) : '?';
+				marker = letter;
+			}
+
+			if(marker == previous) continue;
+			previous = marker;
+
+			if(!sections[o].push_back({ position, letter })) break;
+		}
+	}
+}
+
+void SongIndex::buildSearch(){
+	uint32_t startTime = millis();
+	searchText.clear();
+	words.clear();
+
+	char text[MaxPathLength + 1];
+	for(uint32_t song = 0; song < songs.size(); song++){
+		collationKey(getName(song), text, sizeof(text));
+		size_t length = strlen(text);
+
+		int32_t offset = searchText.append(text, length + 1);
+		if(offset < 0) return;
+
+		for(size_t i = 0; i < length; i++){
+			if(i != 0 && text[i - 1] != ' ') continue;
+			if(!words.push_back({ (uint32_t) (offset + i), song })) return;
+		}
+	}
+
+	const char* textData = searchText.data();
+	std::sort(words.begin(), words.end(), [textData](const Word& a, const Word& b){
+		return strcmp(textData + a.text, textData + b.text) < 0;
+	});
+
+	Serial.printf("SongIndex: %u searchable words, %u bytes, %u ms\n", words.size(),
+				  searchText.size() + words.size() * sizeof(Word), millis() - startTime);
+}
+
+uint32_t SongIndex::search(const char* query, PSRAMVector<uint8_t>& matches) const{
+	if(!matches.resize(songs.size())) return 0;
+	memset(matches.data(), 0, matches.size());
+
+	char key[MaxPathLength + 1];
+	collationKey(query, key, sizeof(key));
+	size_t length = strlen(key);
+	if(length == 0) return 0;
+
+	// Words starting with the query are one run in the sorted table
+	const char* textData = searchText.data();
+	const Word* word = std::lower_bound(words.begin(), words.end(), key, [textData, length](const Word& word, const char* key){
+		return strncmp(textData + word.text, key, length) < 0;
+	});
+
+	uint32_t count = 0;
+	for(; word != words.end() && strncmp(textData + word->text, key, length) == 0; word++){
+		if(matches[word->song]) continue;
+
+		matches[word->song] = 1;
+		count++;
+	}
+
+	return count;
+}
+
+void SongIndex::buildIds(){
+	if(!ids.resize(songs.size())) return;
+
+	for(uint32_t song = 0; song < songs.size(); song++){
+		ids[song] = { getId(song), song };
+	}
+
+	std::sort(ids.begin(), ids.end(), [](const IdEntry& a, const IdEntry& b){
+		return a.id < b.id;
+	});
+}
+
+uint32_t SongIndex::getId(uint32_t song) const{
+	return fnv1a(getPath(song));
+}
+
+int32_t SongIndex::findId(uint32_t id) const{
+	const IdEntry* entry = std::lower_bound(ids.begin(), ids.end(), id, [](const IdEntry& entry, uint32_t id){
+		return entry.id < id;
+	});
+
+	return entry != ids.end() && entry->id == id ? entry->song : -1;
+}
+
+const char* SongIndex::findArtist(const char* name){
+	const char* artist = nullptr;
+	for(const char* dash = strstr(name, " - "); dash != nullptr; dash = strstr(dash + 1, " - ")){
+		artist = dash + 3;
+	}
+
+	return artist;
+}
+
+char SongIndex::sectionLetter(const char* text){
+	char key;
+	collationKey(text, &key, 1);
+
+	if(key >= 'a' && key <= 'z') return key - 'a' + 'A';
+	if(key >= '0' && key <= '9') return '#';
+	return '?';
+}
+
+#ifdef DEBUG
+void SongIndex::benchmark(){
+	const char* benchPath = "/.jayd_song_index.bench";
+	const uint32_t sizes[] = { 100, 1000, 10000 };
+
+	// Left behind if a run was cut short by a reset
+	SD.remove(benchPath);
+
+	for(uint32_t count : sizes){
+		SongIndex index;
+		char directory[64];
+		char song[128];
+		int32_t parent = -1;
+
+		// Artist/album layout with 50 tracks per album
+		for(uint32_t i = 0; i < count; i++){
+			if(i % 50 == 0){
+				snprintf(directory, sizeof(directory), "/Artist %03u/Album %u", i / 500, (i / 50) % 10);
+				Fingerprint fingerprint = { i, fnv1a(directory), 50 };
+				parent = index.addDirectory(directory, fingerprint, -1);
+			}
+
+			snprintf(song, sizeof(song), "%s/Track %05u - Synthetic Artist.aac", directory, i);
+			TrackInfo info;
+			info.sampleRate = 44100;
+			info.duration = 180 + i % 120;
+			info.bitrate = 128;
+			info.channels = 2;
+			index.addSong(parent, song, 1 + i / 1000, info);
+		}
+
+		uint32_t sortTime = micros();
+		index.buildOrders();
+		index.buildSections();
+		index.buildSearch();
+		index.buildIds();
+		sortTime = micros() - sortTime;
+
+		uint32_t storeTime = micros();
+		index.store(SD, benchPath);
+		storeTime = micros() - storeTime;
+
+		fs::File file = SD.open(benchPath);
+		uint32_t fileSize = file.size();
+		file.close();
+
+		SongIndex loaded;
+		uint32_t loadTime = micros();
+		bool ok = loaded.load(SD, benchPath);
+		loadTime = micros() - loadTime;
+
+		PSRAMVector<uint8_t> matches;
+		uint32_t searchTime = micros();
+		uint32_t found = loaded.search("track 01", matches);
+		searchTime = micros() - searchTime;
+
+		Serial.printf("SongIndex: %5u songs - sort %u ms, store %u ms, load %u ms (%s), %u bytes on card, %u bytes of names\n", count,
+					  sortTime / 1000, storeTime / 1000, loadTime / 1000, ok && loaded.getCount() == count ? "ok" : "FAILED", fileSize, loaded.names.size());
+		Serial.printf("SongIndex: %5u songs - search found %u in %u us\n", count, found, searchTime);
+
+		SD.remove(benchPath);
+	}
+}
+#endif
@@ -0,0 +1,196 @@
+#ifndef JAYD_FIRMWARE_SONGINDEX_H
+#define JAYD_FIRMWARE_SONGINDEX_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <functional>
+#include "../Util/PSRAMVector.h"
+#include "../Audio/TrackInfo.h"
+
+// Orderings the index keeps precomputed, so the browser never sorts
+enum SongOrder : uint8_t {
+	BY_NAME, BY_FOLDER, BY_ARTIST, BY_ADDED, ORDER_COUNT
+};
+
+// All playable AAC tracks on the SD card, kept as packed tables in PSRAM and stored in a versioned binary
+// file on the card. Files are probed once when they're first indexed, ones the decoder can't play are left out.
+// Every directory record carries a fingerprint of the directory, so update() only lists directories
+// that changed since the last scan and takes the entries of all others from the index.
+class SongIndex {
+public:
+	// Reads the stored index, false if it's missing, damaged or from another format version
+	bool load();
+	bool store();
+
+	// Same as above with another file, used for the per-card copies in SPIFFS
+	bool load(fs::FS& fs, const char* path);
+	bool store(fs::FS& fs, const char* path) const;
+
+	// Brings the index in line with the card. Returns true if anything changed and the index
+	// should be stored again. found is called with every song path as it's added, cancel is polled
+	// per directory and leaves the index as it was when it returns true.
+	// The tables are swapped at the end, so don't read them from other threads while this runs.
+	bool update(std::function<void(const char* path)> found = {}, std::function<bool()> cancel = {});
+
+	void clear();
+
+	// Deletes the stored index so the next update lists every directory
+	static void remove();
+
+	// Where the card is mounted in the VFS, song paths are relative to it
+	static const char* mountPoint;
+
+	uint32_t getCount() const;
+	const char* getPath(uint32_t song) const;
+	const char* getName(uint32_t song) const;
+
+	// Duration, bitrate and stream format from the song's ADTS headers, probed once when it was indexed
+	const TrackInfo& getInfo(uint32_t song) const;
+
+	// Song number of the track at path, -1 if it isn't indexed
+	int32_t find(const char* path) const;
+
+	// Stable ID of a song (hash of its path). Song numbers change when the card is rescanned, IDs
+	// only when the file is moved, so crates keep these.
+	uint32_t getId(uint32_t song) const;
+	int32_t findId(uint32_t id) const;
+
+	// Song at position in one of the precomputed orderings
+	uint32_t getSong(SongOrder order, uint32_t position) const;
+	static const char* getOrderName(SongOrder order);
+
+	// Start of a run of songs in an ordering that share an initial (name and artist order), folder
+	// (folder order) or update pass (recent order). The browser jumps between them.
+	struct Section {
+		uint32_t position;
+		char letter; // uppercase initial, '#' for digits, '?' for anything else, '+' for the recent order
+	};
+
+	uint32_t getSectionCount(SongOrder order) const;
+	const Section& getSection(SongOrder order, uint32_t section) const;
+
+	// Marks the songs with a word in their name that starts with query, compared after the same folding
+	// as the collation keys so "dua lip" finds "Levitating - Dua Lipa". matches gets a byte per song,
+	// set for every match. Returns the number of songs found.
+	uint32_t search(const char* query, PSRAMVector<uint8_t>& matches) const;
+
+	// Lowercased ASCII letters and digits with every other run of characters folded into one space,
+	// leading separators and the extension dropped. Zero-padded to keySize, UTF-8 bytes kept as they are.
+	static void collationKey(const char* text, char* key, size_t keySize);
+
+	uint32_t getDirectoryCount() const;
+
+#ifdef DEBUG
+	// Stores and loads synthetic indexes of 100, 1k and 10k songs and prints the timings. The scratch
+	// file it writes to the card is deleted when it's done. Run with the "bench index" serial command.
+	static void benchmark();
+#endif
+
+private:
+	// Cheap change check from directory metadata only: mtime plus the count and summed name hashes
+	// of the entries the index cares about (visible subdirectories and .aac files)
+	struct Fingerprint {
+		uint32_t lastWrite;
+		uint32_t nameHash;
+		uint16_t entryCount;
+
+		bool operator==(const Fingerprint& other) const;
+	} __attribute__((packed));
+
+	// Stored as the entry count of a directory with songs that couldn't be probed, no listed directory matches it
+	static const uint16_t Unverified = UINT16_MAX;
+
+	struct Directory {
+		uint32_t path; // offset into names
+		uint32_t pathHash;
+		Fingerprint fingerprint;
+		int32_t parent;
+		uint32_t firstSong;
+		uint16_t songCount;
+	};
+
+	struct Song {
+		uint32_t path; // offset into names, full path
+		uint16_t name; // start of the file name within the path
+		uint16_t directory;
+		uint32_t added; // update pass that first found the song, for the recently added order
+		TrackInfo info;
+	};
+
+	struct Header {
+		char magic[4];
+		uint8_t version;
+		uint8_t reserved[3];
+		uint32_t directoryCount;
+		uint32_t songCount;
+	} __attribute__((packed));
+
+	// Followed by the directory path and songCount entries of { uint32_t added; TrackInfo info; uint8_t length; char name[length]; }.
+	// After the last directory come the ORDER_COUNT orderings, songCount uint32_t song numbers each.
+	struct DirectoryRecord {
+		Fingerprint fingerprint;
+		int32_t parent;
+		uint16_t pathLength;
+		uint16_t songCount;
+	} __attribute__((packed));
+
+	PSRAMVector<Directory> directories;
+	PSRAMVector<Song> songs;
+	PSRAMVector<char> names;
+	PSRAMVector<uint32_t> orders[ORDER_COUNT];
+	PSRAMVector<Section> sections[ORDER_COUNT]; // not stored, rebuilt from the orderings on load
+
+	// Word prefix index for search: every name folded like the collation keys, plus one entry per word
+	// start sorted by the text from there on. Rebuilt on load like the sections.
+	struct Word {
+		uint32_t text; // offset into searchText
+		uint32_t song;
+	};
+	PSRAMVector<char> searchText;
+	PSRAMVector<Word> words;
+
+	// Songs sorted by ID for findId, rebuilt on load as well
+	struct IdEntry {
+		uint32_t id;
+		uint32_t song;
+	};
+	PSRAMVector<IdEntry> ids;
+
+	uint32_t addedStamp = 1;
+	uint32_t listedDirectories = 0;
+	// Listed directories whose fingerprint or songs came out different from the previous index
+	uint32_t changedDirectories = 0;
+	uint32_t reusedDirectories = 0;
+	uint32_t rejectedFiles = 0;
+
+	static const char* path;
+	static const char Magic[4];
+	static const uint8_t Version = 4;
+
+	uint32_t addName(const char* name, size_t length);
+	int32_t addDirectory(const char* path, const Fingerprint& fingerprint, int32_t parent);
+	bool addSong(uint16_t directory, const char* path, uint32_t added, const TrackInfo& info);
+	int32_t findSong(int32_t directory, const char* path) const;
+
+	static const size_t KeySize = 24;
+	void buildOrders();
+	void dropOrders();
+	void buildSections();
+	void buildSearch();
+	void buildIds();
+	static const char* findArtist(const char* name);
+	static char sectionLetter(const char* text);
+
+	int32_t findDirectory(const char* path, uint32_t hash) const;
+
+	static bool isSong(const char* name);
+	static bool readFingerprint(const String& path, Fingerprint& fingerprint);
+	void scanDirectory(const String& path, int32_t parent, const SongIndex& previous, std::function<void(const char*)>& found,
+					   std::function<bool()>& cancel);
+
+	void swap(SongIndex& other);
+};
+
+extern SongIndex Songs;
+
+#endif //JAYD_FIRMWARE_SONGINDEX_H
@@ -0,0 +1,147 @@
+#include "SongScanner.h"
+#include "SongIndex.h"
+#include "CardCache.h"
+
+SongScanner Scanner;
+
+SongScanner::SongScanner() : task("SongScanner", thread, 8 * 1024, this), batches(8, sizeof(Batch)){
+
+}
+
+void SongScanner::begin(){
+	if(task.running) return;
+
+	// UI core, below the loop task so input keeps priority over the card walk
+	task.start(1, 1);
+}
+
+void SongScanner::end(){
+	if(!task.running) return;
+
+	cancel();
+	task.stop(true);
+}
+
+void SongScanner::start(bool stream){
+	begin();
+	cancel();
+
+	cancelled = false;
+	streaming = stream;
+	found = 0;
+	running = true;
+	requested = true;
+}
+
+void SongScanner::cancel(){
+	cancelled = true;
+	streaming = false;
+
+	while(running){
+		delay(5);
+	}
+
+	Batch batch;
+	while(batches.receive(&batch)){
+		release(batch);
+	}
+}
+
+bool SongScanner::isRunning() const{
+	return running;
+}
+
+void SongScanner::stopStream(){
+	streaming = false;
+
+	Batch batch;
+	while(batches.receive(&batch)){
+		release(batch);
+	}
+}
+
+bool SongScanner::receive(Batch& batch){
+	return batches.receive(&batch);
+}
+
+void SongScanner::release(Batch& batch){
+	for(uint8_t i = 0; i < batch.count; i++){
+		free(batch.paths[i]);
+	}
+
+	batch.count = 0;
+}
+
+uint32_t SongScanner::getGeneration() const{
+	return generation;
+}
+
+uint32_t SongScanner::getFound() const{
+	return found;
+}
+
+void SongScanner::send(Batch& batch){
+	// The reader drains the queue from its loop, wait for room instead of dropping songs from the list
+	while(streaming && !cancelled){
+		if(batches.send(&batch, 10)){
+			batch.count = 0;
+			return;
+		}
+	}
+
+	release(batch);
+}
+
+void SongScanner::scan(){
+	Batch batch;
+	batch.count = 0;
+
+	auto onFound = [this, &batch](const char* path){
+		found++;
+		if(!streaming) return;
+
+		batch.paths[batch.count++] = strdup(path);
+		if(batch.count == BatchSize){
+			send(batch);
+		}
+	};
+
+	auto onCancel = [this](){
+		return cancelled || task.isStopped();
+	};
+
+	bool changed = Songs.update(onFound, onCancel);
+
+	if(batch.count > 0){
+		send(batch);
+	}
+
+	// An index that became empty is stored too, otherwise the next boot loads the deleted songs again
+	if(changed){
+		Songs.store();
+	}
+
+	// The flash copy follows every change, and a card seen for the first time gets one too
+	if(changed || (Songs.getCount() != 0 && !Cards.contains())){
+		Cards.store(Songs);
+	}
+
+	if(changed){
+		generation++;
+	}
+}
+
+void SongScanner::thread(Task* task){
+	auto scanner = static_cast<SongScanner*>(task->arg);
+
+	while(task->running){
+		if(!scanner->requested){
+			delay(20);
+			continue;
+		}
+
+		scanner->requested = false;
+		scanner->scan();
+		scanner->running = false;
+	}
+}
@@ -0,0 +1,64 @@
+#ifndef JAYD_FIRMWARE_SONGSCANNER_H
+#define JAYD_FIRMWARE_SONGSCANNER_H
+
+#include <Arduino.h>
+#include <Util/Task.h>
+#include <Sync/Queue.h>
+
+// Runs SongIndex::update on a background task so the UI loop keeps handling input while the card
+// is walked. With streaming on, found songs are sent out in small batches so a list can fill up
+// progressively. The index tables (Songs) must not be read while isRunning() returns true.
+class SongScanner {
+public:
+	static const uint8_t BatchSize = 16;
+
+	struct Batch {
+		uint8_t count;
+		char* paths[BatchSize];
+	};
+
+	SongScanner();
+
+	void begin();
+	void end();
+
+	// Starts an update of Songs. A running one is cancelled first.
+	void start(bool stream);
+
+	// Stops a running update, the index keeps its previous contents. Waits until the task has let go of it.
+	void cancel();
+	bool isRunning() const;
+
+	// Drops undelivered batches and lets the task finish without a reader
+	void stopStream();
+
+	// Paths are heap copies, hand the batch to release() when done with it
+	bool receive(Batch& batch);
+	static void release(Batch& batch);
+
+	// Incremented when a finished update changed and stored the index
+	uint32_t getGeneration() const;
+
+	// Songs streamed so far by the running update
+	uint32_t getFound() const;
+
+private:
+	Task task;
+	Queue batches;
+
+	volatile bool requested = false;
+	volatile bool running = false;
+	volatile bool cancelled = false;
+	volatile bool streaming = false;
+	volatile uint32_t generation = 0;
+	volatile uint32_t found = 0;
+
+	void scan();
+	void send(Batch& batch);
+
+	static void thread(Task* task);
+};
+
+extern SongScanner Scanner;
+
+#endif //JAYD_FIRMWARE_SONGSCANNER_H
@@ -0,0 +1,131 @@
+#include "TrackAnalyzer.h"
+#include "Waveform.h"
+#include "../Audio/SeekIndex.h"
+#include "../Audio/DeckSource.h"
+#include <SD.h>
+
+TrackAnalyzer Analyzer;
+
+TrackAnalyzer::TrackAnalyzer() : task("TrackAnalyzer", thread, 8 * 1024, this), jobs(8, sizeof(char*)){
+
+}
+
+void TrackAnalyzer::begin(){
+	if(task.running) return;
+
+	// Same priority as the UI loop on its core, the audio core is left to the mixer. A whole-track decode
+	// would time-slice with the loop, so the builds yield between chunks (see analyze).
+	task.start(1, 1);
+}
+
+void TrackAnalyzer::end(){
+	if(!task.running) return;
+
+	task.stop(true);
+
+	char* path;
+	while(jobs.receive(&path)){
+		free(path);
+	}
+}
+
+void TrackAnalyzer::request(const char* path){
+	begin();
+
+	char* job = strdup(path);
+	if(!jobs.send(&job)){
+		free(job);
+	}
+}
+
+uint32_t TrackAnalyzer::getGeneration() const{
+	return generation;
+}
+
+void TrackAnalyzer::analyze(const char* path){
+	fs::File track = SD.open(path);
+	if(!track) return;
+
+	// Both builds poll this between chunks
+	uint32_t chunks = 0;
+	auto cancel = [this, &chunks](){
+		if(++chunks % YieldInterval == 0){
+			vTaskDelay(1);
+		}
+		return task.isStopped();
+	};
+
+	if(!SeekIndex::exists(track)){
+		uint32_t startTime = millis();
+		if(SeekIndex::build(track, cancel)){
+			generation++;
+			Serial.printf("TrackAnalyzer: indexed %s in %d ms\n", path, millis() - startTime);
+
+#ifdef DEBUG
+			benchmark(path);
+#endif
+		}else{
+			Serial.printf("TrackAnalyzer: %s not indexed\n", path);
+		}
+	}
+
+	if(!Waveform::exists(track)){
+		uint32_t startTime = millis();
+		if(Waveform::build(track, cancel)){
+			generation++;
+			Serial.printf("TrackAnalyzer: waveform of %s in %d ms\n", path, millis() - startTime);
+		}
+	}
+
+	track.close();
+}
+
+#ifdef DEBUG
+void TrackAnalyzer::benchmark(const char* path){
+	const uint8_t seeks = 16;
+	fs::File track = SD.open(path);
+	int16_t sample[DECK_CHANNELS];
+
+	for(uint8_t indexed = 0; indexed < 2; indexed++){
+		DeckSource source(track, indexed);
+		if(!source.isValid() || source.getDuration() == 0) break;
+
+		uint32_t total = source.getDuration() * source.getSampleRate();
+		uint32_t worst = 0;
+		uint64_t sum = 0;
+
+		for(uint8_t i = 0; i < seeks; i++){
+			// Spread targets over the track in a fixed, non-sequential order
+			uint32_t target = (uint64_t) total * ((i * 7) % seeks) / seeks;
+
+			uint32_t start = micros();
+			source.seekSample(target);
+			source.generate(sample, 1);
+			uint32_t time = micros() - start;
+
+			sum += time;
+			worst = max(worst, time);
+		}
+
+		Serial.printf("TrackAnalyzer: %s seek %s index: avg %u us, worst %u us\n", path, indexed ? "with" : "without",
+					  (uint32_t) (sum / seeks), worst);
+	}
+
+	track.close();
+}
+#endif
+
+void TrackAnalyzer::thread(Task* task){
+	auto analyzer = static_cast<TrackAnalyzer*>(task->arg);
+
+	while(task->running){
+		char* path;
+		if(!analyzer->jobs.receive(&path)){
+			delay(50);
+			continue;
+		}
+
+		analyzer->analyze(path);
+		free(path);
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef JAYD_FIRMWARE_TRACKANALYZER_H
+#define JAYD_FIRMWARE_TRACKANALYZER_H
+
+#include <Arduino.h>
+#include <Util/Task.h>
+#include <Sync/Queue.h>
+
+// Builds missing per-track sidecars on a low-priority task: the .jaydidx seek index first, then the
+// .jaydwf waveform overview. Tracks are queued when a deck loads them, so the data is there from the
+// next load on, or as soon as getGeneration() changes for screens that poll for it.
+class TrackAnalyzer {
+public:
+	TrackAnalyzer();
+
+	void begin();
+	void end();
+
+	void request(const char* path);
+
+	// Incremented every time a sidecar gets written
+	uint32_t getGeneration() const;
+
+private:
+	Task task;
+	Queue jobs;
+	volatile uint32_t generation = 0;
+
+	void analyze(const char* path);
+
+	// Builds sleep a tick every this many chunks, so the UI loop on the same core keeps its cadence
+	static const uint8_t YieldInterval = 4;
+
+#ifdef DEBUG
+	// Prints average seek latency of the same track with and without the index
+	static void benchmark(const char* path);
+#endif
+
+	static void thread(Task* task);
+};
+
+extern TrackAnalyzer Analyzer;
+
+#endif //JAYD_FIRMWARE_TRACKANALYZER_H
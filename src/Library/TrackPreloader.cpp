@@ -0,0 +1,226 @@
+#include "TrackPreloader.h"
+#include "../Audio/ADTS.h"
+#include <SD.h>
+
+TrackPreloader Preloader;
+
+TrackPreloader::TrackPreloader() : task("Preloader", thread, 4 * 1024, this), jobs(4, sizeof(Job)){
+
+}
+
+void TrackPreloader::begin(){
+	if(task.running) return;
+
+	if(mutex == nullptr){
+		mutex = xSemaphoreCreateMutex();
+	}
+
+	// Lowest priority on the audio core - only runs when the mixer thread is blocked on I2S
+	task.start(1, 0);
+}
+
+void TrackPreloader::end(const String& keep){
+	if(!task.running) return;
+
+	cancel();
+	task.stop(true);
+
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	for(auto& entry : cache){
+		if(keep.length() != 0 && entry.path == keep) continue;
+
+		release(entry.head);
+		entry.path = "";
+	}
+	xSemaphoreGive(mutex);
+}
+
+void TrackPreloader::request(const String& path){
+	if(!task.running || path.length() == 0) return;
+
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	bool skip = cached(path) || pending == path;
+	xSemaphoreGive(mutex);
+	if(skip) return;
+
+	Job job = { strdup(path.c_str()), generation };
+	if(!jobs.send(&job)){
+		free(job.path);
+	}
+}
+
+void TrackPreloader::cancel(){
+	generation++;
+
+	Job job;
+	while(jobs.receive(&job)){
+		free(job.path);
+	}
+}
+
+bool TrackPreloader::take(const char* path, TrackHead& head){
+	if(mutex == nullptr) return false;
+
+	bool found = false;
+
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	for(auto& entry : cache){
+		if(entry.head.data == nullptr || entry.path != path) continue;
+
+		head = entry.head;
+		entry.head = TrackHead();
+		entry.path = "";
+		found = true;
+		break;
+	}
+	xSemaphoreGive(mutex);
+
+	if(!found) return false;
+
+	head.file = SD.open(path);
+	if(!head.file){
+		Serial.printf("Preloader: couldn't reopen %s\n", path);
+		release(head);
+		return false;
+	}
+
+	Serial.printf("Preloader: %s served from memory (%d B)\n", path, head.size);
+	return true;
+}
+
+bool TrackPreloader::cached(const String& path){
+	for(const auto& entry : cache){
+		if(entry.head.data != nullptr && entry.path == path) return true;
+	}
+
+	return false;
+}
+
+void TrackPreloader::store(const String& path, const TrackHead& head){
+	// Reuse an empty slot, otherwise evict the least recently stored head
+	Entry* target = &cache[0];
+	for(auto& entry : cache){
+		if(entry.head.data == nullptr){
+			target = &entry;
+			break;
+		}
+
+		if(entry.lastUsed < target->lastUsed){
+			target = &entry;
+		}
+	}
+
+	release(target->head);
+	target->path = path;
+	target->head = head;
+	target->lastUsed = millis();
+}
+
+void TrackPreloader::release(TrackHead& head){
+	if(head.data == nullptr) return;
+
+	free(head.data);
+	if(head.file){
+		head.file.close();
+	}
+	head = TrackHead();
+}
+
+bool TrackPreloader::load(const Job& job){
+	uint32_t startTime = millis();
+
+	TrackHead head;
+	head.file = SD.open(job.path);
+	if(!head.file){
+		Serial.printf("Preloader: couldn't open %s\n", job.path);
+		return false;
+	}
+
+	size_t size = min((size_t) head.file.size(), HeadSize);
+	head.data = static_cast<uint8_t*>(ps_malloc(size));
+	if(head.data == nullptr){
+		Serial.println("Preloader: head buffer malloc failed");
+		head.file.close();
+		return false;
+	}
+
+	// Read in small pieces so a selection change stops the load quickly
+	const size_t chunk = 4096;
+	while(head.size < size){
+		if(job.generation != generation || task.isStopped()){
+			release(head);
+			return false;
+		}
+
+		size_t read = head.file.read(head.data + head.size, min(chunk, size - head.size));
+		if(read == 0) break;
+		head.size += read;
+	}
+
+	// The handle goes back right away, take() opens the file again for the deck
+	head.file.close();
+
+	if(head.size == 0){
+		release(head);
+		return false;
+	}
+
+	// Find the stream and measure its frames now, the deck then only has to start decoding.
+	// A tag too big for the head leaves the layout empty and the deck parses it itself.
+	uint32_t start = ADTS::id3Size(head.data, head.size);
+	int32_t sync = start < head.size ? ADTS::findSync(head.data + start, head.size - start) : -1;
+	ADTSHeader header;
+	if(sync >= 0 && ADTS::measure(head.data + start + sync, head.size - start - sync, header, head.frameBytes) != 0){
+		head.dataStart = start + sync;
+		head.sampleRate = header.sampleRate;
+		head.channels = header.channels;
+	}else if(start < head.size){
+		Serial.printf("Preloader: no ADTS stream in %s\n", job.path);
+		release(head);
+		return false;
+	}
+
+	size_t loaded = head.size;
+	bool current;
+
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	current = job.generation == generation;
+	if(current){
+		store(job.path, head);
+	}else{
+		release(head);
+	}
+	xSemaphoreGive(mutex);
+
+	if(current){
+		Serial.printf("Preloader: %s, %d B in %d ms\n", job.path, loaded, millis() - startTime);
+	}
+
+	return current;
+}
+
+void TrackPreloader::thread(Task* task){
+	auto preloader = static_cast<TrackPreloader*>(task->arg);
+
+	while(task->running){
+		Job job;
+		if(!preloader->jobs.receive(&job)){
+			delay(10);
+			continue;
+		}
+
+		if(job.generation == preloader->generation){
+			xSemaphoreTake(preloader->mutex, portMAX_DELAY);
+			preloader->pending = job.path;
+			xSemaphoreGive(preloader->mutex);
+
+			preloader->load(job);
+
+			xSemaphoreTake(preloader->mutex, portMAX_DELAY);
+			preloader->pending = "";
+			xSemaphoreGive(preloader->mutex);
+		}
+
+		free(job.path);
+	}
+}
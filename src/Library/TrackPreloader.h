@@ -0,0 +1,66 @@
+#ifndef JAYD_FIRMWARE_TRACKPRELOADER_H
+#define JAYD_FIRMWARE_TRACKPRELOADER_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <Util/Task.h>
+#include <Sync/Queue.h>
+#include "../Audio/DeckSource.h"
+
+// Reads the start of the track highlighted in the song list into PSRAM on a low-priority task and
+// parses its stream layout, so the deck that eventually loads it starts decoding from memory instead
+// of waiting on the SD card. Only the few most recent requests are kept, older heads are dropped.
+// Cached heads don't hold their file open, the card only allows a handful of open files.
+class TrackPreloader {
+public:
+	TrackPreloader();
+
+	void begin();
+
+	// Stops loading and releases every cached head except the one for keep, which a deck is about to take
+	void end(const String& keep = "");
+
+	// Queues a track for preloading. Does nothing if it's already cached or being loaded.
+	void request(const String& path);
+
+	// Drops pending and in-flight loads, already cached heads are kept
+	void cancel();
+
+	// Hands over the preloaded head for path with the file opened again. The caller owns the file and buffer afterwards.
+	bool take(const char* path, TrackHead& head);
+
+	static const size_t HeadSize = 32 * 1024;
+	static const uint8_t CacheSize = 3;
+
+private:
+	struct Entry {
+		String path;
+		TrackHead head;
+		uint32_t lastUsed = 0;
+	};
+
+	struct Job {
+		char* path;
+		uint32_t generation;
+	};
+
+	Entry cache[CacheSize];
+	SemaphoreHandle_t mutex = nullptr;
+
+	Task task;
+	Queue jobs;
+	volatile uint32_t generation = 0;
+
+	String pending; // path currently being read by the task
+
+	bool cached(const String& path);
+	void store(const String& path, const TrackHead& head);
+	bool load(const Job& job);
+	static void release(TrackHead& head);
+
+	static void thread(Task* task);
+};
+
+extern TrackPreloader Preloader;
+
+#endif //JAYD_FIRMWARE_TRACKPRELOADER_H
@@ -0,0 +1,135 @@
+#include "Waveform.h"
+#include "../Audio/DeckSource.h"
+#include <SD.h>
+
+const char Waveform::Magic[4] = { 'J', 'D', 'W', 'F' };
+
+String Waveform::sidecarPath(const char* trackPath){
+	String path = trackPath;
+	int dot = path.lastIndexOf('.');
+	if(dot > path.lastIndexOf('/')){
+		path = path.substring(0, dot);
+	}
+
+	return path + ".jaydwf";
+}
+
+bool Waveform::readHeader(fs::File& track, fs::File& sidecar){
+	sidecar = SD.open(sidecarPath(track.name()));
+	if(!sidecar) return false;
+
+	Header header;
+	return sidecar.read(reinterpret_cast<uint8_t*>(&header), sizeof(Header)) == sizeof(Header)
+		   && memcmp(header.magic, Magic, sizeof(Magic)) == 0
+		   && header.version == Version
+		   && header.columns == Columns
+		   && header.fileSize == track.size()
+		   && header.lastWrite == (uint32_t) track.getLastWrite();
+}
+
+bool Waveform::exists(fs::File& track){
+	fs::File sidecar;
+	bool ok = readHeader(track, sidecar);
+	sidecar.close();
+	return ok;
+}
+
+bool Waveform::load(fs::File& track){
+	clear();
+
+	fs::File sidecar;
+	if(readHeader(track, sidecar)){
+		loaded = sidecar.read(peak, Columns) == Columns && sidecar.read(rms, Columns) == Columns;
+	}
+	sidecar.close();
+
+	if(!loaded){
+		clear();
+	}
+
+	return loaded;
+}
+
+void Waveform::clear(){
+	memset(peak, 0, Columns);
+	memset(rms, 0, Columns);
+	loaded = false;
+}
+
+bool Waveform::isLoaded() const{
+	return loaded;
+}
+
+uint8_t Waveform::getPeak(uint8_t column) const{
+	return column < Columns ? peak[column] : 0;
+}
+
+uint8_t Waveform::getRMS(uint8_t column) const{
+	return column < Columns ? rms[column] : 0;
+}
+
+bool Waveform::build(fs::File& track, std::function<bool()> cancel){
+	DeckSource source(track);
+	if(!source.isValid() || source.getDuration() == 0) return false;
+
+	int16_t* block = static_cast<int16_t*>(malloc(DECK_BLOCK_BYTES));
+	if(block == nullptr) return false;
+
+	uint64_t total = (uint64_t) source.getDuration() * source.getSampleRate();
+
+	uint16_t peaks[Columns] = { 0 };
+	uint64_t squares[Columns] = { 0 };
+	uint32_t counts[Columns] = { 0 };
+
+	bool aborted = false;
+	uint64_t position = 0;
+
+	while(!source.isDone()){
+		if(cancel && cancel()){
+			aborted = true;
+			break;
+		}
+
+		size_t samples = source.generate(block);
+		if(samples == 0) break;
+
+		for(size_t i = 0; i < samples; i++){
+			uint8_t column = min((uint64_t) Columns - 1, (position + i) * Columns / total);
+			int32_t mono = (block[i * 2] + block[i * 2 + 1]) / 2;
+			uint16_t level = abs(mono);
+
+			peaks[column] = max(peaks[column], level);
+			squares[column] += mono * mono;
+			counts[column]++;
+		}
+
+		position += samples;
+	}
+
+	free(block);
+	if(aborted || position == 0) return false;
+
+	Header header = {};
+	memcpy(header.magic, Magic, sizeof(Magic));
+	header.version = Version;
+	header.columns = Columns;
+	header.fileSize = track.size();
+	header.lastWrite = track.getLastWrite();
+
+	uint8_t peak[Columns];
+	uint8_t rms[Columns];
+	for(uint8_t i = 0; i < Columns; i++){
+		peak[i] = min(255, peaks[i] >> 7);
+		rms[i] = counts[i] == 0 ? 0 : min(255, (int) sqrtf((float) squares[i] / counts[i]) >> 7);
+	}
+
+	fs::File out = SD.open(sidecarPath(track.name()), FILE_WRITE);
+	if(!out) return false;
+
+	out.write(reinterpret_cast<uint8_t*>(&header), sizeof(Header));
+	out.write(peak, Columns);
+	out.write(rms, Columns);
+	out.close();
+
+	return true;
+}
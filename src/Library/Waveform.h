@@ -0,0 +1,50 @@
+#ifndef JAYD_FIRMWARE_WAVEFORM_H
+#define JAYD_FIRMWARE_WAVEFORM_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <functional>
+
+// Peak and RMS envelope of a whole track, one column per pixel of the MixScreen seek bar.
+// Stored next to the track (song.aac -> song.jaydwf) and tied to its size and modification time.
+class Waveform {
+public:
+	static const uint8_t Columns = 72;
+
+	// Loads the sidecar of track, returns false if it's missing or stale
+	bool load(fs::File& track);
+	void clear();
+	bool isLoaded() const;
+
+	// Levels are 0 - 255 of full scale
+	uint8_t getPeak(uint8_t column) const;
+	uint8_t getRMS(uint8_t column) const;
+
+	// Decodes the whole track and writes its sidecar. Run from a background task,
+	// cancel is polled between decoded blocks.
+	static bool build(fs::File& track, std::function<bool()> cancel = {});
+
+	static bool exists(fs::File& track);
+	static String sidecarPath(const char* trackPath);
+
+private:
+	struct Header {
+		char magic[4];
+		uint8_t version;
+		uint8_t columns;
+		uint16_t reserved;
+		uint32_t fileSize;
+		uint32_t lastWrite;
+	} __attribute__((packed));
+
+	static const char Magic[4];
+	static const uint8_t Version = 1;
+
+	uint8_t peak[Columns] = { 0 };
+	uint8_t rms[Columns] = { 0 };
+	bool loaded = false;
+
+	static bool readHeader(fs::File& track, fs::File& sidecar);
+};
+
+#endif //JAYD_FIRMWARE_WAVEFORM_H
@@ -0,0 +1,49 @@
+#include "MixSettings.h"
+#include <SPIFFS.h>
+
+MixSettingsImpl MixSettings;
+
+const char* MixSettingsImpl::path = "/mixSettings.bin";
+
+void MixSettingsImpl::begin(){
+	fs::File file = SPIFFS.open(path);
+	if(!file){
+		reset();
+		return;
+	}
+
+	uint8_t version = 0;
+	file.read(&version, 1);
+
+	// Settings written by another firmware version don't map onto this struct, start from defaults
+	if(version != Version || file.size() != 1 + sizeof(MixSettingsData)){
+		file.close();
+		Serial.println("MixSettings: stored settings outdated, using defaults");
+		reset();
+		return;
+	}
+
+	file.read(reinterpret_cast<uint8_t*>(&data), sizeof(MixSettingsData));
+	file.close();
+}
+
+void MixSettingsImpl::store(){
+	fs::File file = SPIFFS.open(path, FILE_WRITE);
+	if(!file){
+		Serial.println("MixSettings: couldn't store settings");
+		return;
+	}
+
+	file.write(Version);
+	file.write(reinterpret_cast<uint8_t*>(&data), sizeof(MixSettingsData));
+	file.close();
+}
+
+void MixSettingsImpl::reset(){
+	data = MixSettingsData();
+	store();
+}
+
+MixSettingsData& MixSettingsImpl::get(){
+	return data;
+}
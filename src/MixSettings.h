@@ -0,0 +1,35 @@
+#ifndef JAYD_FIRMWARE_MIXSETTINGS_H
+#define JAYD_FIRMWARE_MIXSETTINGS_H
+
+#include <Arduino.h>
+#include "Audio/CrossfadeCurve.h"
+
+// Mixer preferences that aren't part of the library's Settings, stored on SPIFFS
+struct MixSettingsData {
+	uint8_t crossfadeCurve = SMOOTH;
+
+	// Parameter smoothing time constants in ms, see SmoothedValue. The crossfader is kept short
+	// so cuts stay sharp, the effects are slow enough to hide coefficient changes.
+	uint16_t volumeSmoothing = 20;
+	uint16_t crossfadeSmoothing = 4;
+	uint16_t intensitySmoothing = 60;
+};
+
+class MixSettingsImpl {
+public:
+	void begin();
+	void store();
+	void reset();
+
+	MixSettingsData& get();
+
+private:
+	MixSettingsData data;
+
+	static const char* path;
+	static const uint8_t Version = 2;
+};
+
+extern MixSettingsImpl MixSettings;
+
+#endif //JAYD_FIRMWARE_MIXSETTINGS_H
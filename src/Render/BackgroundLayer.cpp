@@ -0,0 +1,70 @@
+#include "BackgroundLayer.h"
+
+BackgroundLayer::BackgroundLayer(Screen& screen) : screen(screen){
+
+}
+
+BackgroundLayer::~BackgroundLayer(){
+	release();
+}
+
+bool BackgroundLayer::restore(){
+	uint16_t* pixels = screenBuffer();
+	if(!captured || pixels == nullptr) return false;
+
+	memcpy(pixels, buffer, size);
+	return true;
+}
+
+bool BackgroundLayer::restore(int16_t y, int16_t height){
+	uint16_t* pixels = screenBuffer();
+	if(!captured || pixels == nullptr) return false;
+
+	// Full width rows are contiguous, so a band is still one copy
+	int32_t width = screen.getSprite()->width();
+	y = constrain(y, 0, screen.getSprite()->height());
+	height = constrain(height, 0, screen.getSprite()->height() - y);
+	memcpy(pixels + y * width, buffer + y * width, width * height * sizeof(uint16_t));
+	return true;
+}
+
+bool BackgroundLayer::capture(){
+	uint16_t* pixels = screenBuffer();
+	if(pixels == nullptr) return false;
+
+	size_t needed = screen.getSprite()->width() * screen.getSprite()->height() * sizeof(uint16_t);
+	if(buffer == nullptr || size != needed){
+		free(buffer);
+		size = needed;
+		buffer = static_cast<uint16_t*>(ps_malloc(size));
+		if(buffer == nullptr){
+			Serial.println("BackgroundLayer: cache alloc error");
+			size = 0;
+			captured = false;
+			return false;
+		}
+	}
+
+	memcpy(buffer, pixels, size);
+	captured = true;
+	return true;
+}
+
+void BackgroundLayer::invalidate(){
+	captured = false;
+}
+
+bool BackgroundLayer::isCaptured() const{
+	return captured;
+}
+
+void BackgroundLayer::release(){
+	free(buffer);
+	buffer = nullptr;
+	size = 0;
+	captured = false;
+}
+
+uint16_t* BackgroundLayer::screenBuffer() const{
+	return static_cast<uint16_t*>(screen.getSprite()->getBuffer());
+}
@@ -0,0 +1,42 @@
+#ifndef JAYD_FIRMWARE_BACKGROUNDLAYER_H
+#define JAYD_FIRMWARE_BACKGROUNDLAYER_H
+
+#include <Arduino.h>
+#include <UI/Screen.h>
+
+// Cached copy of a screen's static layers (background picture, panel fills, borders). They're drawn into
+// the screen once and captured, after that every frame starts with a single copy back from PSRAM and
+// only the elements that move are drawn on top.
+class BackgroundLayer {
+public:
+	explicit BackgroundLayer(Screen& screen);
+	virtual ~BackgroundLayer();
+
+	// Copies the cached layers into the screen. Returns false if there's nothing cached yet,
+	// the static layers should then be drawn and captured.
+	bool restore();
+
+	// Copies only rows y to y + height back, to cover elements that were drawn past them
+	bool restore(int16_t y, int16_t height);
+
+	// Keeps what's currently in the screen as the static layers
+	bool capture();
+
+	// Static layers changed, they're drawn again and captured on the next frame
+	void invalidate();
+	bool isCaptured() const;
+
+	// Frees the cache while the screen is packed
+	void release();
+
+private:
+	Screen& screen;
+
+	uint16_t* buffer = nullptr;
+	size_t size = 0;
+	bool captured = false;
+
+	uint16_t* screenBuffer() const;
+};
+
+#endif //JAYD_FIRMWARE_BACKGROUNDLAYER_H
@@ -0,0 +1,129 @@
+#include "Compositor.h"
+#include <Display/Display.h>
+
+Compositor::Compositor(Screen& screen) : screen(screen){
+
+}
+
+void Compositor::invalidate(int16_t x, int16_t y, int16_t width, int16_t height){
+	if(full) return;
+
+	// Clip to the screen
+	int16_t right = min<int16_t>(x + width, screen.getWidth());
+	int16_t bottom = min<int16_t>(y + height, screen.getHeight());
+	x = max<int16_t>(x, 0);
+	y = max<int16_t>(y, 0);
+	if(right <= x || bottom <= y) return;
+
+	Rect rect = { x, y, (int16_t) (right - x), (int16_t) (bottom - y) };
+
+	// Anything touching the new rectangle is folded into it, which can make it touch others again
+	for(uint8_t i = 0; i < count;){
+		if(rects[i].touches(rect)){
+			rect = rect.unite(rects[i]);
+			rects[i] = rects[--count];
+			i = 0;
+		}else{
+			i++;
+		}
+	}
+
+	if(count == FramePusher::MaxRects){
+		// Out of slots, grow the rectangle that gets the least bigger by taking this one in
+		uint8_t best = 0;
+		int32_t bestGrowth = INT32_MAX;
+		for(uint8_t i = 0; i < count; i++){
+			int32_t growth = rects[i].unite(rect).area() - rects[i].area();
+			if(growth < bestGrowth){
+				bestGrowth = growth;
+				best = i;
+			}
+		}
+
+		rects[best] = rects[best].unite(rect);
+	}else{
+		rects[count++] = rect;
+	}
+
+	int32_t damaged = 0;
+	for(uint8_t i = 0; i < count; i++){
+		damaged += rects[i].area();
+	}
+
+	if(damaged * 100 >= (int32_t) screen.getWidth() * screen.getHeight() * FullPercent){
+		invalidateAll();
+	}
+}
+
+void Compositor::invalidate(Element* element){
+	if(element == nullptr) return;
+	invalidate(element->getTotalX(), element->getTotalY(), element->getWidth(), element->getHeight());
+}
+
+void Compositor::invalidateAll(){
+	full = true;
+	count = 0;
+}
+
+bool Compositor::isDirty() const{
+	return full || count != 0;
+}
+
+void Compositor::commit(){
+	if(!isDirty()) return;
+
+	rendered++;
+	if(Pusher.isBusy()){
+		dropped++;
+		return;
+	}
+
+	// Back buffer into the display's frame buffer, then the transfer runs on the pusher task
+	screen.getSprite()->push();
+
+	if(full){
+		Rect frame = { 0, 0, (int16_t) screen.getWidth(), (int16_t) screen.getHeight() };
+		Pusher.push(screen.getDisplay(), &frame, 1);
+	}else{
+		Pusher.push(screen.getDisplay(), rects, count);
+	}
+
+	full = false;
+	count = 0;
+
+#ifdef DEBUG
+	report();
+#endif
+}
+
+void Compositor::wait(){
+	Pusher.wait();
+}
+
+uint32_t Compositor::getFramesRendered() const{
+	return rendered;
+}
+
+uint32_t Compositor::getFramesDropped() const{
+	return dropped;
+}
+
+#ifdef DEBUG
+void Compositor::report(){
+	if(reportTime == 0 || millis() - reportTime >= ReportInterval){
+		if(reportTime != 0){
+			uint32_t pushed = Pusher.getFramesPushed() - reportPushed;
+			uint32_t pixels = Pusher.getPixelsPushed() - reportPixels;
+			Serial.printf("Compositor: %u frames rendered, %u pushed, %u dropped, %u px/frame (%u%% of a full frame)\n",
+						  rendered - reportRendered, pushed, dropped - reportDropped, pushed ? pixels / pushed : 0,
+						  pushed ? pixels * 100 / (pushed * screen.getWidth() * screen.getHeight()) : 0);
+		}
+
+		reportTime = millis();
+		reportRendered = rendered;
+		reportDropped = dropped;
+		reportPushed = Pusher.getFramesPushed();
+		reportPixels = Pusher.getPixelsPushed();
+	}
+}
+#endif
@@ -0,0 +1,61 @@
+#ifndef JAYD_FIRMWARE_COMPOSITOR_H
+#define JAYD_FIRMWARE_COMPOSITOR_H
+
+#include <Arduino.h>
+#include <UI/Screen.h>
+#include <UI/Element.h>
+#include "FramePusher.h"
+
+// Tracks which parts of a screen changed and pushes only those to the panel. The screen is still drawn
+// whole into its sprite, that's cheap next to the SPI transfer. Damaged rectangles are merged as they
+// come in so no pixel goes out twice, and once most of the screen is damaged the whole frame is pushed.
+// Frames go out through FramePusher. One rendered while the previous is still being sent is dropped
+// and its damage carried over, so the screen stays dirty and the next frame covers it.
+class Compositor {
+public:
+	explicit Compositor(Screen& screen);
+
+	void invalidate(int16_t x, int16_t y, int16_t width, int16_t height);
+	void invalidate(Element* element);
+	void invalidateAll();
+
+	bool isDirty() const;
+
+	// Hands the damaged rectangles of the drawn screen to the pusher and clears them,
+	// or keeps them for the next frame if the pusher is still busy
+	void commit();
+
+	// Waits for the frame in flight, call before the screen stops and others draw to the panel
+	void wait();
+
+	// Frames committed, and the ones of them skipped because the panel was still busy
+	uint32_t getFramesRendered() const;
+	uint32_t getFramesDropped() const;
+
+private:
+	typedef FramePusher::Rect Rect;
+
+	Screen& screen;
+
+	Rect rects[FramePusher::MaxRects];
+	uint8_t count = 0;
+	bool full = false;
+
+	uint32_t rendered = 0;
+	uint32_t dropped = 0;
+
+#ifdef DEBUG
+	uint32_t reportTime = 0;
+	uint32_t reportRendered = 0;
+	uint32_t reportDropped = 0;
+	uint32_t reportPushed = 0;
+	uint32_t reportPixels = 0;
+	void report();
+#endif
+
+	// Share of the screen above which pushing it whole is cheaper than many windows
+	static const uint8_t FullPercent = 70;
+	static const uint16_t ReportInterval = 5000;
+};
+
+#endif //JAYD_FIRMWARE_COMPOSITOR_H
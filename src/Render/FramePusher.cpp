@@ -0,0 +1,105 @@
+#include "FramePusher.h"
+
+FramePusher Pusher;
+
+FramePusher::FramePusher() : task("FramePusher", thread, 2 * 1024, this){
+
+}
+
+void FramePusher::begin(){
+	if(task.running) return;
+
+	// Audio core, below the mixer task so decoding always comes first
+	task.start(1, 0);
+}
+
+void FramePusher::end(){
+	if(!task.running) return;
+
+	wait();
+	task.stop(true);
+}
+
+bool FramePusher::isBusy() const{
+	return busy;
+}
+
+void FramePusher::wait() const{
+	while(busy){
+		delay(1);
+	}
+}
+
+bool FramePusher::push(Display* display, const Rect* rects, uint8_t count){
+	if(busy) return false;
+
+	begin();
+
+	this->display = display;
+	this->count = min(count, MaxRects);
+	memcpy(this->rects, rects, this->count * sizeof(Rect));
+	busy = true;
+
+	return true;
+}
+
+uint32_t FramePusher::getFramesPushed() const{
+	return framesPushed;
+}
+
+uint32_t FramePusher::getPixelsPushed() const{
+	return pixelsPushed;
+}
+
+void FramePusher::send(){
+	Sprite* frame = display->getBaseSprite();
+	const uint16_t* pixels = static_cast<const uint16_t*>(frame->getBuffer());
+	uint16_t stride = frame->width();
+	auto tft = display->getTft();
+
+	tft->startWrite();
+	for(uint8_t i = 0; i < count; i++){
+		const Rect& rect = rects[i];
+		tft->setWindow(rect.x, rect.y, rect.x + rect.width - 1, rect.y + rect.height - 1);
+
+		// Sprite pixels are already in panel byte order
+		for(int16_t row = rect.y; row < rect.y + rect.height; row++){
+			tft->pushColors(const_cast<uint16_t*>(pixels + row * stride + rect.x), rect.width, false);
+		}
+
+		pixelsPushed += rect.area();
+	}
+	tft->endWrite();
+
+	framesPushed++;
+}
+
+void FramePusher::thread(Task* task){
+	auto pusher = static_cast<FramePusher*>(task->arg);
+
+	while(task->running){
+		if(!pusher->busy){
+			delay(1);
+			continue;
+		}
+
+		pusher->send();
+		pusher->busy = false;
+	}
+}
+
+int32_t FramePusher::Rect::area() const{
+	return (int32_t) width * height;
+}
+
+bool FramePusher::Rect::touches(const Rect& other) const{
+	return x <= other.x + other.width && other.x <= x + width && y <= other.y + other.height && other.y <= y + height;
+}
+
+FramePusher::Rect FramePusher::Rect::unite(const Rect& other) const{
+	int16_t left = min(x, other.x);
+	int16_t top = min(y, other.y);
+	int16_t right = max<int16_t>(x + width, other.x + other.width);
+	int16_t bottom = max<int16_t>(y + height, other.y + other.height);
+	return { left, top, (int16_t) (right - left), (int16_t) (bottom - top) };
+}
@@ -0,0 +1,61 @@
+#ifndef JAYD_FIRMWARE_FRAMEPUSHER_H
+#define JAYD_FIRMWARE_FRAMEPUSHER_H
+
+#include <Arduino.h>
+#include <Util/Task.h>
+#include <Display/Display.h>
+
+// Second half of the display double buffer. Screens draw into their sprite (the back buffer), a finished
+// frame is copied into the display's frame buffer (the front buffer) and this task sends it to the panel
+// on the audio core, in the time the mixer leaves idle. The UI loop carries on while the transfer runs
+// and only has to skip a frame if the previous one is still going out.
+// The transfer is a polled write. LovyanGFX's DMA path can't read from PSRAM, where the frame buffer
+// lives, and the damaged rectangles aren't contiguous in it anyway.
+class FramePusher {
+public:
+	struct Rect {
+		int16_t x, y, width, height;
+
+		int32_t area() const;
+		bool touches(const Rect& other) const;
+		Rect unite(const Rect& other) const;
+	};
+
+	static const uint8_t MaxRects = 8;
+
+	FramePusher();
+
+	void begin();
+	void end();
+
+	// True while a frame is being sent, the front buffer mustn't be written then
+	bool isBusy() const;
+
+	// Blocks until the frame in flight is out, before anything else draws to the panel directly
+	void wait() const;
+
+	// Sends rects of display's frame buffer. Returns false without doing anything if still busy.
+	bool push(Display* display, const Rect* rects, uint8_t count);
+
+	uint32_t getFramesPushed() const;
+	uint32_t getPixelsPushed() const;
+
+private:
+	Task task;
+
+	Display* display = nullptr;
+	Rect rects[MaxRects];
+	uint8_t count = 0;
+
+	volatile bool busy = false;
+	volatile uint32_t framesPushed = 0;
+	volatile uint32_t pixelsPushed = 0;
+
+	void send();
+
+	static void thread(Task* task);
+};
+
+extern FramePusher Pusher;
+
+#endif //JAYD_FIRMWARE_FRAMEPUSHER_H
@@ -0,0 +1,102 @@
+#include "FrameScheduler.h"
+#include "../Audio/DeckMixer.h"
+
+const uint16_t FrameScheduler::BucketLimits[BucketCount - 1] = { 2, 5, 10, 20, 40, 80 };
+
+FrameScheduler::FrameScheduler(const char* name, uint8_t fps) : name(name){
+	setFps(fps);
+}
+
+void FrameScheduler::setFps(uint8_t fps){
+	interval = 1000 / max<uint8_t>(fps, 1);
+}
+
+uint8_t FrameScheduler::getFps() const{
+	return 1000 / interval;
+}
+
+void FrameScheduler::invalidate(){
+	invalid = true;
+}
+
+bool FrameScheduler::isInvalid() const{
+	return invalid;
+}
+
+bool FrameScheduler::run(const std::function<void()>& frame){
+	if(!invalid) return false;
+
+	uint32_t now = millis();
+	uint32_t elapsed = now - lastFrame;
+	if(elapsed < interval) return false;
+
+	// Due at the target rate, but held back for the audio thread. Counted once per held frame.
+	if(elapsed < currentInterval()){
+		if(!deferring){
+			deferring = true;
+			deferred++;
+		}
+		return false;
+	}
+
+	invalid = false;
+	deferring = false;
+	lastFrame = now;
+
+	uint32_t start = micros();
+	frame();
+	uint32_t time = (micros() - start) / 1000;
+
+	uint8_t bucket = 0;
+	while(bucket < BucketCount - 1 && time >= BucketLimits[bucket]){
+		bucket++;
+	}
+	histogram[bucket]++;
+	frames++;
+
+#ifdef DEBUG
+	report();
+#endif
+
+	return true;
+}
+
+uint16_t FrameScheduler::getBucketLimit(uint8_t bucket){
+	return bucket < BucketCount - 1 ? BucketLimits[bucket] : UINT16_MAX;
+}
+
+uint32_t FrameScheduler::getBucket(uint8_t bucket) const{
+	return bucket < BucketCount ? histogram[bucket] : 0;
+}
+
+uint32_t FrameScheduler::getFrameCount() const{
+	return frames;
+}
+
+uint32_t FrameScheduler::getDeferredCount() const{
+	return deferred;
+}
+
+uint16_t FrameScheduler::currentInterval() const{
+	uint8_t load = DeckMixer::getLoad();
+	if(load >= CriticalLoad) return interval * 4;
+	if(load >= HighLoad) return interval * 2;
+	return interval;
+}
+
+#ifdef DEBUG
+void FrameScheduler::report(){
+	if(reportTime == 0){
+		reportTime = millis();
+		return;
+	}
+	if(millis() - reportTime < ReportInterval) return;
+	reportTime = millis();
+
+	Serial.printf("FrameScheduler %s: %u frames, %u deferred, audio load %u%%, ms:", name, frames, deferred, DeckMixer::getLoad());
+	for(uint8_t i = 0; i < BucketCount - 1; i++){
+		Serial.printf(" <%u:%u", BucketLimits[i], histogram[i]);
+	}
+	Serial.printf(" >=%u:%u\n", BucketLimits[BucketCount - 2], histogram[BucketCount - 1]);
+}
+#endif
@@ -0,0 +1,60 @@
+#ifndef JAYD_FIRMWARE_FRAMESCHEDULER_H
+#define JAYD_FIRMWARE_FRAMESCHEDULER_H
+
+#include <Arduino.h>
+#include <functional>
+
+// Paces a screen's redraws. Changes only mark the screen invalid, any number of them between two frames
+// cost one redraw, and frames come no faster than the screen's target rate. While the audio thread is
+// busy decoding the interval is stretched, so the UI gives way before the audio would underrun.
+// How long frames take is kept in a histogram.
+class FrameScheduler {
+public:
+	FrameScheduler(const char* name, uint8_t fps);
+
+	void setFps(uint8_t fps);
+	uint8_t getFps() const;
+
+	// Something on the screen changed, the next due frame redraws it
+	void invalidate();
+	bool isInvalid() const;
+
+	// Runs frame if the screen is invalid and a frame is due, and times it. Returns true if it ran.
+	bool run(const std::function<void()>& frame);
+
+	// Frame time histogram, bucket i holds frames that took under getBucketLimit(i) ms,
+	// the last one everything longer
+	static const uint8_t BucketCount = 7;
+	static uint16_t getBucketLimit(uint8_t bucket);
+	uint32_t getBucket(uint8_t bucket) const;
+
+	uint32_t getFrameCount() const;
+	uint32_t getDeferredCount() const;
+
+private:
+	const char* name;
+	uint16_t interval;
+
+	bool invalid = false;
+	uint32_t lastFrame = 0;
+
+	uint32_t histogram[BucketCount] = { 0 };
+	uint32_t frames = 0;
+	uint32_t deferred = 0;
+	bool deferring = false;
+
+	uint16_t currentInterval() const;
+
+	// Audio load above which frames come at half and at a quarter of the target rate
+	static const uint8_t HighLoad = 60;
+	static const uint8_t CriticalLoad = 80;
+	static const uint16_t BucketLimits[BucketCount - 1];
+
+#ifdef DEBUG
+	uint32_t reportTime = 0;
+	void report();
+	static const uint16_t ReportInterval = 10000;
+#endif
+};
+
+#endif //JAYD_FIRMWARE_FRAMESCHEDULER_H
@@ -0,0 +1,67 @@
+#include "TextStrip.h"
+
+TextStrip::~TextStrip(){
+	delete strip;
+}
+
+int32_t TextStrip::set(const String& text, const lgfx::IFont* font, uint16_t color){
+	if(strip == nullptr){
+		strip = new LGFX_Sprite();
+		strip->setPsram(true);
+		strip->setColorDepth(1);
+	}
+
+	strip->setFont(font);
+	int32_t textWidth = strip->textWidth(text.c_str());
+	int32_t needed = constrain(textWidth, 1, MaxWidth);
+	int32_t height = strip->fontHeight();
+
+	// The buffer is kept between names and only grows, rows rebind often while a list scrolls
+	if(strip->getBuffer() == nullptr || strip->width() < needed || strip->height() != height){
+		strip->deleteSprite();
+		if(strip->createSprite(needed, height) == nullptr){
+			Serial.printf("TextStrip: couldn't allocate %dx%d\n", needed, height);
+			width = 0;
+			return textWidth;
+		}
+		strip->createPalette();
+	}
+
+	// Index 0 is left transparent when blitting, 1 is the text
+	strip->setPaletteColor(1, color);
+	strip->fillSprite(0);
+	strip->setTextColor(1);
+	strip->setTextDatum(TL_DATUM);
+	strip->drawString(text.c_str(), 0, 0);
+
+	width = min(textWidth, MaxWidth);
+	return textWidth;
+}
+
+void TextStrip::clear(){
+	if(strip != nullptr){
+		strip->deleteSprite();
+	}
+	width = 0;
+}
+
+bool TextStrip::isEmpty() const{
+	return width == 0;
+}
+
+int32_t TextStrip::getWidth() const{
+	return width;
+}
+
+int32_t TextStrip::getHeight() const{
+	return isEmpty() ? 0 : strip->height();
+}
+
+void TextStrip::draw(Sprite* canvas, int32_t x, int32_t y, int32_t clipX, int32_t clipWidth) const{
+	if(isEmpty() || clipWidth <= 0) return;
+	if(x >= clipX + clipWidth || x + width <= clipX) return;
+
+	canvas->setClipRect(clipX, y, clipWidth, strip->height());
+	strip->pushSprite(canvas, x, y, 0);
+	canvas->clearClipRect();
+}
@@ -0,0 +1,32 @@
+#ifndef JAYD_FIRMWARE_TEXTSTRIP_H
+#define JAYD_FIRMWARE_TEXTSTRIP_H
+
+#include <Arduino.h>
+#include <Display/Sprite.h>
+
+// A line of text rendered once into a 1-bit offscreen sprite in PSRAM. Scrolling labels blit it at an
+// offset and clipped to their box every frame instead of shaping the text again.
+class TextStrip {
+public:
+	virtual ~TextStrip();
+
+	// Renders text in font and color, returns its width in pixels
+	int32_t set(const String& text, const lgfx::IFont* font, uint16_t color);
+	void clear();
+
+	bool isEmpty() const;
+	int32_t getWidth() const;
+	int32_t getHeight() const;
+
+	// Draws the text with its top left at x, y, showing only what falls between clipX and clipX + clipWidth
+	void draw(Sprite* canvas, int32_t x, int32_t y, int32_t clipX, int32_t clipWidth) const;
+
+private:
+	LGFX_Sprite* strip = nullptr;
+	int32_t width = 0;
+
+	// Longer text is cut, it would never scroll by in a sensible time anyway
+	static const int32_t MaxWidth = 2048;
+};
+
+#endif //JAYD_FIRMWARE_TEXTSTRIP_H
@@ -3,7 +3,13 @@
 #include <Loop/LoopManager.h>
 #include <JayD.h>
 #include <FS/CompressedFile.h>
+#include <Util/Task.h>
+#include <AudioLib/SourceWAV.h>
+#include <AudioLib/OutputAAC.h>
 #include "MixScreen.h"
+#include "../../Library/TrackAnalyzer.h"
+#include "../../Library/SongIndex.h"
+#include "../../Library/SongScanner.h"
 #include "../SongList/SongList.h"
 #include "../MainMenu/MainMenu.h"
 #include "../TextInputScreen/TextInputScreen.h"
@@ -18,8 +24,8 @@ MixScreen::MixScreen::MixScreen(Display& display) : Context(display),
 													leftSeekBar(new SongSeekBar(leftLayout)),
 													rightSeekBar(new SongSeekBar(rightLayout)),
 													leftSongName(new SongName(leftLayout)),
-													rightSongName(new SongName(rightLayout)), leftVu(&matrixManager.matrixL), rightVu(&matrixManager.matrixR),
-													midVu(&matrixManager.matrixBig){
+													rightSongName(new SongName(rightLayout)), compositor(screen), background(screen), scheduler("MixScreen", Fps), leftVu(&matrixManager.matrixL), rightVu(&matrixManager.matrixR),
+													midVu(&matrixManager.matrixBig), timeline("MixScreen"){
 
 	Serial.println("\n=== MIXSCREEN CONSTRUCTOR START ===");
 	Serial.printf("Free heap: %u bytes\n", ESP.getFreeHeap());
@@ -44,6 +50,7 @@ MixScreen::MixScreen::MixScreen(Display& display) : Context(display),
 }
 
 MixScreen::MixScreen::~MixScreen(){
+	compositor.wait();
 	instance = nullptr;
 	free(selectedBackgroundBuffer);
 }
@@ -52,6 +59,7 @@ void MixScreen::MixScreen::pack(){
 	Context::pack();
 	free(selectedBackgroundBuffer);
 	selectedBackgroundBuffer = nullptr;
+	background.release();
 }
 
 void MixScreen::MixScreen::unpack(){
@@ -115,7 +123,7 @@ void MixScreen::MixScreen::unpack(){
 }
 
 void MixScreen::MixScreen::saveRecording(){
-	if(!SD.exists(MixSystem::recordPath)){
+	if(!SD.exists(DeckMixer::recordPath)){
 		doneRecording = false;
 		return;
 	}
@@ -127,7 +135,7 @@ void MixScreen::MixScreen::saveRecording(){
 			SD.remove(saveFilename);
 		}
 
-		File inFile = SD.open(MixSystem::recordPath);
+		File inFile = SD.open(DeckMixer::recordPath);
 		File outFile = SD.open(saveFilename, "w");
 
 		SourceWAV input(inFile);
@@ -153,13 +161,14 @@ void MixScreen::MixScreen::saveRecording(){
 		if(millis() - lastDraw >= 30){
 			lastDraw = millis();
 			drawSaveStatus();
-			screen.commit();
+			compositor.invalidate((screen.getWidth() - 80) / 2, (screen.getHeight() - 40) / 2, 80, 40);
+			compositor.commit();
 		}
 
 		Sched.loop(0);
 	}
 
-	SD.remove(MixSystem::recordPath);
+	SD.remove(DeckMixer::recordPath);
 	doneRecording = false;
 }
 
@@ -245,18 +254,6 @@ void MixScreen::MixScreen::returned(void* data){
 		}else if(!f2){
 			Serial.println("Assigning to f2 (player 2)");
 			
-			// POWER MANAGEMENT: If audio is playing, pause it during file operations
-			// This prevents power spikes that cause brownout resets
-			bool wasChannelPlaying = false;
-			if(system){
-				Serial.println("Pausing audio to prevent power spike during f2 loading");
-				wasChannelPlaying = !system->isChannelPaused(0);
-				if(wasChannelPlaying){
-					system->pauseChannel(0);
-					delay(50); // Allow audio system to settle
-				}
-			}
-			
 			f2 = newFile;
 			if(f2 && f2.size() > 0){
 				f2.seek(0);
@@ -266,23 +263,15 @@ void MixScreen::MixScreen::returned(void* data){
 				Serial.printf("f2 assigned: %s\n", songName.c_str());
 				
 				// Update UI immediately
-				drawQueued = true;
+				compositor.invalidate(rightLayout);
 				
-				// CRITICAL: If MixSystem exists, we need to update it to know about f2
+				// If the mixer is already running, give f2 its own decoder - player 1 keeps playing
 				Serial.printf("System exists: %s\n", system ? "YES" : "NO");
-				if(system){
-					Serial.println("WARNING: MixSystem exists but doesn't know about new f2!");
-					Serial.println("Deferring MixSystem update to prevent power issues");
+				if(system && !system->replaceChannel(1, f2)){
+					Serial.println("ERROR: f2 could not be decoded");
 				}
 			}
 			
-			// Resume audio if it was playing
-			if(system && wasChannelPlaying){
-				Serial.println("Resuming audio after f2 loading");
-				delay(50); // Small delay before resuming
-				system->resumeChannel(0);
-			}
-			
 			keepAudioOnStop = false;
 		}else{
 			Serial.println("Both decks full - closing file");
@@ -299,15 +288,22 @@ void MixScreen::MixScreen::setBigVuStarted(bool bigVuStarted){
 	MixScreen::bigVuStarted = bigVuStarted;
 }
 
+bool MixScreen::MixScreen::getBeatInfo(uint8_t channel, BeatInfo& info){
+	fs::File& file = channel == 0 ? f1 : f2;
+	return Beats.get(file, info);
+}
+
 void MixScreen::MixScreen::start(){
 	Serial.println("\n=== MIXSCREEN START ===");
+	bool resumingHotSwap = justCompletedHotSwap;
 	Serial.printf("f1: %s, f2: %s, system: %p\n", 
 		f1 ? "loaded" : "null", f2 ? "loaded" : "null", system);
 	
 	if(doneRecording){
 		lastDraw = 0;
+		compositor.invalidateAll();
 		draw();
-		screen.commit();
+		compositor.commit();
 		saveRecording();
 	}
 
@@ -318,11 +314,14 @@ void MixScreen::MixScreen::start(){
 		Serial.printf("DEBUG: f1 size = %d, f2 size = %d\n", 
 			f1 ? f1.size() : 0, f2 ? f2.size() : 0);
 		// No tracks loaded - go to song selection for the first track
+		compositor.invalidateAll();
 		draw();
-		screen.commit();
-		delay(100); // Small delay to ensure display is stable
-		
-		(new SongList::SongList(*getScreen().getDisplay()))->push(this);
+		compositor.commit();
+
+		// Let the display settle before switching screens
+		timeline.then("song list", 100, [this](){
+			(new SongList::SongList(*getScreen().getDisplay()))->push(this);
+		});
 		return;
 	}
 
@@ -357,21 +356,14 @@ void MixScreen::MixScreen::start(){
 	if(system){
 		Serial.println("INFO: MixSystem already exists - using existing system");
 		// If system exists and we just completed hot-swap, preserve states
-		if(justCompletedHotSwap){
+		if(resumingHotSwap){
 			Serial.println("Hot-swap system already configured - skipping start sequence");
 		}
 	}else if(f1 || f2){
 		Serial.println("Creating MixSystem...");
-		
-		// POWER MANAGEMENT: Add delay before MixSystem creation
-		// to allow power supply to stabilize
-		delay(100);
-		
-		system = new MixSystem(f1, f2);
+		system = new DeckMixer(f1, f2);
+		tempoSync = new TempoSync(system);
 		Serial.printf("MixSystem created: %p\n", system);
-		
-		// Another delay after creation to prevent immediate power spikes
-		delay(50);
 	}else{
 		Serial.println("No files - skipping MixSystem creation");
 		system = nullptr;
@@ -379,54 +371,49 @@ void MixScreen::MixScreen::start(){
 
 	if(system){
 		// Skip configuration if we just completed hot-swap (already configured)
-		if(justCompletedHotSwap){
+		if(resumingHotSwap){
 			Serial.println("Skipping MixSystem configuration - already done in hot-swap");
 		}else{
-			Serial.println("Configuring MixSystem with power management...");
-			
-			// Spread out power-hungry operations with delays
+			Serial.println("Configuring MixSystem...");
+
 			system->setVolume(0, InputJayD::getInstance()->getPotValue(POT_L));
-			delay(10);
 			system->setVolume(1, InputJayD::getInstance()->getPotValue(POT_R));
-			delay(10);
 
 			system->setChannelInfo(0, leftVu.getInfoGenerator());
-			delay(10);
 			system->setChannelInfo(1, rightVu.getInfoGenerator());
-			delay(10);
 			system->setChannelInfo(2, midVu.getInfoGenerator());
-			delay(10);
-			
+
 			if(bigVuStarted){
 				startBigVu();
-				delay(10);
 			}
 
 			uint8_t potMidVal = InputJayD::getInstance()->getPotValue(POT_MID);
 			system->setMix(potMidVal);
-			delay(10);
 			matrixManager.fillMatrixMid(potMidVal);
 			matrixManager.matrixMid.push();
-			delay(10);
 		}
 
 		// Always update seek bar durations (but preserve playing states for hot-swap)
 		if(f1){
-			leftSeekBar->setTotalDuration(system->getDuration(0));
-			if(!justCompletedHotSwap){
+			leftSeekBar->setTrack(f1.name());
+			leftSeekBar->setTotalDuration(getTrackDuration(0, f1.name()));
+			if(!resumingHotSwap){
 				leftSeekBar->setPlaying(false); // Start paused - user controls playback
 			}
 		}else{
+			leftSeekBar->clearTrack();
 			leftSeekBar->setTotalDuration(0);
 			leftSeekBar->setPlaying(false);
 		}
 		
 		if(f2){
-			rightSeekBar->setTotalDuration(system->getDuration(1));
-			if(!justCompletedHotSwap){
+			rightSeekBar->setTrack(f2.name());
+			rightSeekBar->setTotalDuration(getTrackDuration(1, f2.name()));
+			if(!resumingHotSwap){
 				rightSeekBar->setPlaying(false); // Start paused - user controls playback
 			}
 		}else{
+			rightSeekBar->clearTrack();
 			rightSeekBar->setTotalDuration(0);
 			rightSeekBar->setPlaying(false);
 		}
@@ -442,7 +429,8 @@ void MixScreen::MixScreen::start(){
 	leftSongName->checkScrollUpdate();
 	rightSongName->checkScrollUpdate();
 
-	for(int i = 0; i < 6; i++){
+	// Effect chains survive a hot-swap in the mixer, so only reset them on a fresh start
+	for(int i = 0; i < 6 && !resumingHotSwap; i++){
 		// Auto-select default effects: first slot = SPEED, second slot = HIGHPASS
 		if(i == 0 || i == 3){
 			effectElements[i]->setType(SPEED);  // First effect slot for both players
@@ -464,41 +452,33 @@ void MixScreen::MixScreen::start(){
 
 	if(system){
 		// Check if we just completed a hot-swap - if so, system is already running
-		if(justCompletedHotSwap){
+		if(resumingHotSwap){
 			Serial.println("Hot-swap detected - system already running, preserving states");
 			Serial.printf("Hot-swap validation: f1=%s (size=%d), f2=%s (size=%d)\n",
 				f1 ? "valid" : "null", f1 ? f1.size() : 0,
 				f2 ? "valid" : "null", f2 ? f2.size() : 0);
 			justCompletedHotSwap = false; // Reset the flag
+			Serial.println("MixSystem ready");
+			Serial.println("Hot-swap detected - skipping effect initialization to preserve playback");
 		}else{
+			// POWER MANAGEMENT: I2S and the amplifier come up after the power supply has settled from
+			// decoder setup. Steps run from the loop, so the screen and inputs stay live meanwhile.
 			Serial.println("Starting MixSystem with power management...");
-			
-			// POWER MANAGEMENT: Delay before starting to prevent power spike
-			delay(50);
-			system->start();
-			
-			// Allow system to stabilize after start
-			delay(50);
-			
-			Serial.println("Normal start - pausing all channels");
-			// Ensure both channels start paused - user controls when to play
-			if(f1){
-				system->pauseChannel(0);
-				delay(10);
-			}
-			if(f2){
-				system->pauseChannel(1);
-				delay(10);
-			}
-		}
-		
-		Serial.println("MixSystem ready");
-		
-		// Initialize default effects only on first startup, not during hot-swap
-		if(!justCompletedHotSwap){
-			initializeDefaultEffects();
-		}else{
-			Serial.println("Hot-swap detected - skipping effect initialization to preserve playback");
+
+			timeline.then("power settle", 100, [this](){
+				if(system) system->start();
+			}).then("start settle", 50, [this](){
+				if(!system) return;
+
+				Serial.println("Normal start - pausing all channels");
+				// Ensure both channels start paused - user controls when to play
+				if(f1) system->pauseChannel(0);
+				if(f2) system->pauseChannel(1);
+
+				// Initialize default effects only on first startup, not during hot-swap
+				initializeDefaultEffects();
+				Serial.println("MixSystem ready");
+			});
 		}
 	}
 
@@ -520,14 +500,21 @@ void MixScreen::MixScreen::start(){
 		InputJayD::getInstance()->addListener(this);
 	}
 
+	compositor.invalidateAll();
 	draw();
-	screen.commit();
+	compositor.commit();
 	
 	Serial.printf("=== MIXSCREEN START COMPLETE - System: %p ===\n\n", system);
 }
 
 void MixScreen::MixScreen::stop(){
 	Serial.printf("=== MIXSCREEN STOP - System: %p ===\n", system);
+
+	// The next screen commits straight to the panel, the last frame has to be out by then
+	compositor.wait();
+
+	// Pending steps still expect the mixer, run them before it may be deleted below
+	timeline.finish();
 	
 	// Remove UI listeners but keep VU listeners if preserving audio
 	if(!keepAudioOnStop){
@@ -553,6 +540,8 @@ void MixScreen::MixScreen::stop(){
 	if(system && !keepAudioOnStop){
 		Serial.printf("Stopping and deleting MixSystem: %p (audio not preserved)\n", system);
 		system->stop();
+		delete tempoSync;
+		tempoSync = nullptr;
 		delete system;
 		system = nullptr;
 		listenersActive = false;
@@ -566,19 +555,23 @@ void MixScreen::MixScreen::stop(){
 }
 
 void MixScreen::MixScreen::draw(){
-	screen.getSprite()->fillRect(79, 0, 2, 128, TFT_BLACK);
-	screen.getSprite()->fillRect(leftLayout->getTotalX(), leftLayout->getTotalY(), 79, 128, C_RGB(249, 93, 2));
-	screen.getSprite()->fillRect(rightLayout->getTotalX(), rightLayout->getTotalY(), 79, 128, C_RGB(3, 52, 135));
-	
-	// Draw selection indication - always use white border style
-	if(!selectedChannel){
-		// Left channel selected - draw white border on left
-		screen.getSprite()->drawRect(leftLayout->getTotalX(), leftLayout->getTotalY(), 79, 128, TFT_WHITE);
-		screen.getSprite()->drawRect(leftLayout->getTotalX()+1, leftLayout->getTotalY()+1, 77, 126, TFT_WHITE);
-	}else{
-		// Right channel selected - draw white border on right
-		screen.getSprite()->drawRect(rightLayout->getTotalX(), rightLayout->getTotalY(), 79, 128, TFT_WHITE);
-		screen.getSprite()->drawRect(rightLayout->getTotalX()+1, rightLayout->getTotalY()+1, 77, 126, TFT_WHITE);
+	if(!background.restore()){
+		screen.getSprite()->fillRect(79, 0, 2, 128, TFT_BLACK);
+		screen.getSprite()->fillRect(leftLayout->getTotalX(), leftLayout->getTotalY(), 79, 128, C_RGB(249, 93, 2));
+		screen.getSprite()->fillRect(rightLayout->getTotalX(), rightLayout->getTotalY(), 79, 128, C_RGB(3, 52, 135));
+
+		// Draw selection indication - always use white border style
+		if(!selectedChannel){
+			// Left channel selected - draw white border on left
+			screen.getSprite()->drawRect(leftLayout->getTotalX(), leftLayout->getTotalY(), 79, 128, TFT_WHITE);
+			screen.getSprite()->drawRect(leftLayout->getTotalX()+1, leftLayout->getTotalY()+1, 77, 126, TFT_WHITE);
+		}else{
+			// Right channel selected - draw white border on right
+			screen.getSprite()->drawRect(rightLayout->getTotalX(), rightLayout->getTotalY(), 79, 128, TFT_WHITE);
+			screen.getSprite()->drawRect(rightLayout->getTotalX()+1, rightLayout->getTotalY()+1, 77, 126, TFT_WHITE);
+		}
+
+		background.capture();
 	}
 
 	if(isRecording){
@@ -649,39 +642,6 @@ void MixScreen::MixScreen::buildUI(){
 }
 
 void MixScreen::MixScreen::loop(uint micros){
-	// Handle scheduled auto-resume after hot-swap
-	if(pendingAutoResume && millis() >= autoResumeScheduledTime){
-		if(system && !hotSwapInProgress && !isLoadingTrack){
-			uint8_t channel = pendingAutoResumeChannel;
-			SongSeekBar* seekBar = (channel == 0) ? leftSeekBar : rightSeekBar;
-			fs::File& trackFile = (channel == 0) ? f1 : f2;
-			
-			if(trackFile && trackFile.size() > 0){
-				Serial.printf("Executing auto-resume: simulating play button press on channel %d\n", channel);
-				
-				if(system->isChannelPaused(channel)){
-					// Use preserved position from seek bar
-					uint32_t preservedPos = seekBar->getCurrentDuration();
-					Serial.printf("Auto-resume: Using preserved position %u seconds on channel %d\n", preservedPos, channel);
-					
-					// Seek to preserved position first
-					if(preservedPos > 0){
-						system->seekChannel(channel, preservedPos);
-						delay(100); // Let seek complete
-					}
-					
-					// Minimal delays for better audio continuity
-					delay(50); // Reduced pre-resume delay
-					system->resumeChannel(channel);
-					delay(25); // Minimal post-resume stabilization
-					seekBar->setPlaying(true);
-					Serial.printf("Auto-resume completed: Channel %d playing from position %u\n", channel, preservedPos);
-				}
-			}
-		}
-		pendingAutoResume = false;
-	}
-	
 	if(system && seekTime != 0 && millis() - seekTime >= 100){
 		SongSeekBar* bar = seekChannel ? rightSeekBar : leftSeekBar;
 
@@ -695,143 +655,94 @@ void MixScreen::MixScreen::loop(uint micros){
 		seekTime = 0;
 	}
 
-	bool update = false;
-	for(const auto& element : effectElements){
-		update |= element->needsUpdate();
+	if(tempoSync){
+		tempoSync->update();
 	}
 
-	// Only update seek bars for channels with valid tracks
-	if(system && f1 && f1.size() > 0 && system->getDuration(0) != leftSeekBar->getTotalDuration()){
-		leftSeekBar->setTotalDuration(system->getDuration(0));
-		update = true;
+	for(const auto& element : effectElements){
+		if(element->needsUpdate()){
+			compositor.invalidate(element);
+		}
 	}
 
-	if(system && f2 && f2.size() > 0 && system->getDuration(1) != rightSeekBar->getTotalDuration()){
-		rightSeekBar->setTotalDuration(system->getDuration(1));
-		update = true;
+	// Pick up waveforms the analyzer finished for tracks already on the decks
+	if(Analyzer.getGeneration() != analyzerGeneration){
+		analyzerGeneration = Analyzer.getGeneration();
+		if(leftSeekBar->reloadWaveform()){
+			compositor.invalidate(leftSeekBar);
+		}
+		if(rightSeekBar->reloadWaveform()){
+			compositor.invalidate(rightSeekBar);
+		}
 	}
 
-	// Update seek bar positions, but respect smart resume timing
+	// Update seek bar positions, except on the channel currently being scrubbed
 	if(system && f1 && f1.size() > 0 && system->getElapsed(0) != leftSeekBar->getCurrentDuration()){
 		if(seekTime == 0 || seekChannel != 0){
-			// Don't overwrite position immediately after smart seek (give decoder time to catch up)
-			uint32_t timeSinceSmartSeek = millis() - lastSmartSeekTime[0];
-			if(lastSmartSeekTime[0] == 0 || timeSinceSmartSeek > 3000){ // 3 second grace period
-				leftSeekBar->setCurrentDuration(system->getElapsed(0));
-				update = true;
-			}else{
-				// During grace period, log what's happening
-				if(timeSinceSmartSeek % 1000 < 50){ // Log once per second during grace period
-					Serial.printf("Grace period: Channel 0 - System elapsed: %d, Seek bar: %d, Time since seek: %d ms\n", 
-						system->getElapsed(0), leftSeekBar->getCurrentDuration(), timeSinceSmartSeek);
-				}
-			}
+			leftSeekBar->setCurrentDuration(system->getElapsed(0));
+			compositor.invalidate(leftSeekBar);
 		}
 	}
 
 	if(system && f2 && f2.size() > 0 && system->getElapsed(1) != rightSeekBar->getCurrentDuration()){
 		if(seekTime == 0 || seekChannel != 1){
-			// Don't overwrite position immediately after smart seek (give decoder time to catch up)
-			uint32_t timeSinceSmartSeek = millis() - lastSmartSeekTime[1];
-			if(lastSmartSeekTime[1] == 0 || timeSinceSmartSeek > 3000){ // 3 second grace period
-				rightSeekBar->setCurrentDuration(system->getElapsed(1));
-				update = true;
-			}else{
-				// During grace period, log what's happening
-				if(timeSinceSmartSeek % 1000 < 50){ // Log once per second during grace period
-					Serial.printf("Grace period: Channel 1 - System elapsed: %d, Seek bar: %d, Time since seek: %d ms\n", 
-						system->getElapsed(1), rightSeekBar->getCurrentDuration(), timeSinceSmartSeek);
-				}
-			}
+			rightSeekBar->setCurrentDuration(system->getElapsed(1));
+			compositor.invalidate(rightSeekBar);
 		}
 	}
 
 	if(system && system->isRecording() != isRecording){
 		isRecording = system->isRecording();
-		update = true;
+		scheduler.setFps(isRecording ? RecordingFps : Fps);
+
+		// Recording dot sits on the gap between the deck panels
+		compositor.invalidate(79 - 7, 64 - 7, 15, 15);
 	}
 
 	if(system && f1 && f1.size() > 0 && system->isChannelPaused(0) != !leftSeekBar->isPlaying() && seekTime == 0){
 		leftSeekBar->setPlaying(!system->isChannelPaused(0));
-		update = true;
+		compositor.invalidate(leftSeekBar);
 	}
 
 	if(system && f2 && f2.size() > 0 && system->isChannelPaused(1) != !rightSeekBar->isPlaying() && seekTime == 0){
 		rightSeekBar->setPlaying(!system->isChannelPaused(1)); // Fixed: was incorrectly using channel 0
-		update = true;
+		compositor.invalidate(rightSeekBar);
 	}
 
-	bool songNameUpdateL = leftSongName->checkScrollUpdate();
-	bool songNameUpdateR = rightSongName->checkScrollUpdate();
-	update |= songNameUpdateL | songNameUpdateR;
+	if(leftSongName->checkScrollUpdate()){
+		compositor.invalidate(leftSongName);
+	}
+	if(rightSongName->checkScrollUpdate()){
+		compositor.invalidate(rightSongName);
+	}
 
-	uint32_t currentTime = millis();
-	if((update || drawQueued) && (currentTime - lastDraw) >= (isRecording ? 200 : 50)){
-		drawQueued = false;
-		draw();
-		screen.commit();
-		lastDraw = currentTime;
-	}else if(update){
-		drawQueued = true;
+	// A frame dropped by a busy panel leaves the compositor dirty, the scheduler picks it up again
+	if(compositor.isDirty()){
+		scheduler.invalidate();
 	}
+	scheduler.run([this](){
+		draw();
+		compositor.commit();
+	});
 }
 
-
-uint8_t MixScreen::MixScreen::applyCrossfaderCurve(uint8_t rawValue){
-	// Professional DJ crossfader curve with sharper cut and better blending
-	// Range: 0-255, with 128 as center
-	
-	float normalized = (float)rawValue / 255.0f; // 0.0 to 1.0
-	float curve;
-	
-	if(normalized < 0.5f){
-		// Left side (0.0 to 0.5): Exponential curve for sharp cut
-		float leftSide = normalized * 2.0f; // 0.0 to 1.0
-		curve = pow(leftSide, 2.5f) * 0.5f; // Steeper curve, map to 0.0-0.5
-	}else{
-		// Right side (0.5 to 1.0): Exponential curve for sharp cut
-		float rightSide = (normalized - 0.5f) * 2.0f; // 0.0 to 1.0
-		curve = 0.5f + (pow(rightSide, 2.5f) * 0.5f); // Steeper curve, map to 0.5-1.0
-	}
-	
-	return (uint8_t)(curve * 255.0f);
+LinearLayout* MixScreen::MixScreen::getDeckLayout(uint8_t channel) const{
+	return channel == 0 ? leftLayout : rightLayout;
 }
 
+
 void MixScreen::MixScreen::potMove(uint8_t id, uint8_t value){
 	if(!system) return;
 	
-	// Prevent crossfader jumps during hot-swap by ignoring rapid changes
-	static uint32_t lastCrossfaderUpdate = 0;
-	static uint8_t lastCrossfaderValue = 128;
-	
 	if(id == POT_MID){
-		uint32_t now = millis();
-		
-		// Detect crossfader jumps (hardware glitches during hot-swap)
-		bool isJump = abs((int)value - (int)lastCrossfaderValue) > 50 && 
-		              (now - lastCrossfaderUpdate) < 100;
-		
-		if(!hotSwapInProgress && !isJump){
-			// Apply professional DJ crossfader curve
-			uint8_t curvedValue = applyCrossfaderCurve(value);
-			
-			system->setMix(curvedValue);
-			matrixManager.fillMatrixMid(value); // Visual uses raw value for smooth display
-			matrixManager.matrixMid.push();
-			
-			// Track last valid crossfader value (use raw value for hardware tracking)
-			lastValidMixVal = value;
-			lastCrossfaderValue = value;
-			lastCrossfaderUpdate = now;
-		}
+		// Fast cuts are passed through as-is, the mixer smooths the gain on the audio side
+		system->setMix(value);
+		matrixManager.fillMatrixMid(value); // Visual uses raw value for smooth display
+		matrixManager.matrixMid.push();
 	}else if(id == POT_L){
 		system->setVolume(0, value);
-		// Track last valid left volume value
-		lastValidLeftVol = value;
 	}else if(id == POT_R){
 		system->setVolume(1, value);
-		// Track last valid right volume value
-		lastValidRightVol = value;
 	}
 }
 
@@ -901,6 +812,13 @@ void MixScreen::MixScreen::btn(uint8_t i){
 		return;
 	}
 	
+	// Until the start steps have run they still pause the decks and set the default effects,
+	// a deck control used before then would be undone. Deck input waits for them.
+	if(timeline.isBusy()){
+		Serial.println("Still starting - ignoring deck input");
+		return;
+	}
+
 	// Check if the channel has a valid track
 	if((i == 0 && (!f1 || f1.size() == 0)) || 
 	   (i == 1 && (!f2 || f2.size() == 0))){
@@ -924,20 +842,7 @@ void MixScreen::MixScreen::btn(uint8_t i){
 		if(wasPlaying){
 			system->pauseChannel(i);
 		}else{
-			// SMART RESUME: If channel is paused and has a position > 0, seek first
-			uint32_t currentPos = bar->getCurrentDuration();
-			Serial.printf("Resume check: Channel %d current position = %d\n", i, currentPos);
-			
-			if(currentPos > 0){
-				Serial.printf("Smart resume: Seeking to position %d before playing\n", currentPos);
-				system->seekChannel(i, currentPos);
-				lastSmartSeekTime[i] = millis(); // Update to track the actual seek time
-				delay(150); // Allow seek to complete before resume
-			}else{
-				Serial.printf("No smart resume needed: Channel %d starting from position 0\n", i);
-				// If no smart resume needed, clear any protection
-				lastSmartSeekTime[i] = 0;
-			}
+			// The paused deck is frozen at its exact sample with the decoder warm, resume continues from there
 			system->resumeChannel(i);
 		}
 		
@@ -947,7 +852,7 @@ void MixScreen::MixScreen::btn(uint8_t i){
 		Serial.println("ERROR: System became null during button press!");
 	}
 	
-	drawQueued = true;
+	compositor.invalidate(bar);
 	Serial.println("=== BTN END ===\n");
 }
 
@@ -955,17 +860,21 @@ void MixScreen::MixScreen::btnEnc(uint8_t i){
 	if(i > 6) return;
 
 	if(i == 6){
+		// Selection border moves from one deck panel to the other
 		selectedChannel = !selectedChannel;
+		background.invalidate();
+		compositor.invalidate(leftLayout);
+		compositor.invalidate(rightLayout);
 	}else{
 		EffectElement* effect = effectElements[i];
 		effect->setSelected(!effect->isSelected());
+		compositor.invalidate(effect);
 	}
-
-	drawQueued = true;
 }
 
 void MixScreen::MixScreen::enc(uint8_t index, int8_t value){
 	if(!system) return; // No system yet - can't use encoders for audio control
+	if(timeline.isBusy()) return; // Start steps would undo it, see btn()
 
 	if(index == 6){
 		// Check if the selected channel has a valid track
@@ -987,7 +896,7 @@ void MixScreen::MixScreen::enc(uint8_t index, int8_t value){
 		uint16_t newSeekTime = constrain(bar->getCurrentDuration() + value, 0, maxDuration);
 		bar->setCurrentDuration(newSeekTime);
 
-		drawQueued = true;
+		compositor.invalidate(bar);
 		return;
 	}
 
@@ -1021,6 +930,9 @@ void MixScreen::MixScreen::enc(uint8_t index, int8_t value){
 
 		if(element->getType() == EffectType::SPEED){
 			system->removeSpeed(index >= 3);
+			if(tempoSync->isEngaged() && tempoSync->getFollower() == (index >= 3)){
+				tempoSync->disengage();
+			}
 		}
 
 		EffectType type = static_cast<EffectType>(e);
@@ -1045,13 +957,28 @@ void MixScreen::MixScreen::enc(uint8_t index, int8_t value){
 		element->setIntensity(intensity);
 
 		if(type == EffectType::SPEED){
+			// Turning the speed by hand takes the deck out of sync
+			if(tempoSync->isEngaged() && tempoSync->getFollower() == (index >= 3)){
+				tempoSync->disengage();
+			}
 			system->setSpeed(index >= 3, intensity);
 		}else{
 			system->setEffectIntensity(index >= 3, index < 3 ? index : index - 3, element->getIntensity());
 		}
 	}
 
-	drawQueued = true;
+	compositor.invalidate(element);
+}
+
+uint16_t MixScreen::MixScreen::getTrackDuration(uint8_t deck, const char* path){
+	uint16_t duration = system ? system->getDuration(deck) : 0;
+	if(duration != 0) return duration;
+
+	// The scanner swaps the index tables when it finishes, only read them while it's idle
+	if(Scanner.isRunning()) return 0;
+
+	int32_t song = Songs.find(path);
+	return song < 0 ? 0 : Songs.getInfo(song).duration;
 }
 
 void MixScreen::MixScreen::hotSwapTrack(uint8_t deck, fs::File newFile){
@@ -1071,302 +998,65 @@ void MixScreen::MixScreen::hotSwapTrack(uint8_t deck, fs::File newFile){
 		return;
 	}
 	
-	hotSwapInProgress = true;
-	
-	// Use stored hardware mixer values captured when button was held
-	uint8_t leftVol = storedLeftVol;
-	uint8_t rightVol = storedRightVol;
-	uint8_t mixVal = storedMixVal;
-	
-	Serial.printf("Using stored hardware mixer values: Vol L=%d, Vol R=%d, Mix=%d\n", leftVol, rightVol, mixVal);
-	
-	// Declare channel state variables at function scope
-	bool channel0WasPlaying = false;
-	bool channel1WasPlaying = false;
-	uint32_t channel0Position = 0;
-	uint32_t channel1Position = 0;
-	
 	// Validate the new file first
 	if(!newFile || newFile.size() == 0){
 		Serial.println("ERROR: Invalid file for hot-swap");
 		if(newFile) newFile.close();
-		hotSwapInProgress = false;
 		return;
 	}
 	
+	hotSwapInProgress = true;
+	
 	Serial.printf("Hot-swapping file: %s (size: %d)\n", newFile.name(), newFile.size());
+	Serial.printf("Pre-swap memory: heap=%u\n", ESP.getFreeHeap());
 	
-	// Close the old file and assign the new one
-	if(deck == 0){
-		Serial.println("Hot-swapping f1 (player 1)");
-		if(f1) {
-			Serial.printf("Closing old f1: %s\n", f1.name());
-			f1.close();
-		}
-		f1 = newFile;
-		f1.seek(0);
-		String name = f1.name();
-		String songName = name.substring(name.lastIndexOf('/') + 1, name.length() - 4);
-		leftSongName->setSongName(songName);
-		Serial.printf("f1 hot-swapped to: %s\n", songName.c_str());
-	}else{
-		Serial.println("Hot-swapping f2 (player 2)");
-		if(f2) {
-			Serial.printf("Closing old f2: %s\n", f2.name());
-			f2.close();
-		}
-		f2 = newFile;
-		f2.seek(0);
-		String name = f2.name();
-		String songName = name.substring(name.lastIndexOf('/') + 1, name.length() - 4);
-		rightSongName->setSongName(songName);
-		Serial.printf("f2 hot-swapped to: %s\n", songName.c_str());
+	// Only the replaced deck gets a new decoder. The other deck keeps streaming, and volumes,
+	// crossfader, effect chains and VU bindings stay in the mixer untouched.
+	if(!system->replaceChannel(deck, newFile)){
+		Serial.println("ERROR: New track could not be decoded - keeping the old one");
+		newFile.close();
+		hotSwapInProgress = false;
+		isLoadingTrack = false;
+		keepAudioOnStop = false;
+		return;
 	}
 	
-	// Show the track name change immediately  
-	drawQueued = true;
+	fs::File& deckFile = deck == 0 ? f1 : f2;
+	SongName* songName = deck == 0 ? leftSongName : rightSongName;
+	SongSeekBar* seekBar = deck == 0 ? leftSeekBar : rightSeekBar;
 	
-	// SMART HOT-SWAP: Update MixSystem without full context restart
-	// This preserves audio playback during track loading
-	Serial.println("Updating MixSystem to include new track...");
-	Serial.printf("Pre-update memory: heap=%u\n", ESP.getFreeHeap());
+	// The mixer decodes from its own file handle, so the old one can be closed right away
+	if(deckFile){
+		Serial.printf("Closing old f%d: %s\n", deck + 1, deckFile.name());
+		deckFile.close();
+	}
+	deckFile = newFile;
 	
-	if(system){
-		Serial.printf("Recreating MixSystem with updated files (old: %p)\n", system);
-		
-		// CRITICAL: Prevent any system access during recreation
-		hotSwapInProgress = true;
-		
-		// CRITICAL: Store playback states before recreating system
-		
-		if(f1 && f1.size() > 0){
-			channel0WasPlaying = !system->isChannelPaused(0);
-			channel0Position = system->getElapsed(0);
-			Serial.printf("Channel 0 state: %s at position %d\n", 
-				channel0WasPlaying ? "PLAYING" : "PAUSED", channel0Position);
-		}
-		
-		if(f2 && f2.size() > 0){
-			channel1WasPlaying = !system->isChannelPaused(1);
-			channel1Position = system->getElapsed(1);
-			Serial.printf("Channel 1 state: %s at position %d\n", 
-				channel1WasPlaying ? "PLAYING" : "PAUSED", channel1Position);
-		}
-		
-		// IMPORTANT: If no channel is currently playing, avoid recreation entirely
-		if(!channel0WasPlaying && !channel1WasPlaying){
-			Serial.println("No channels playing - using simple system recreation");
-			// We can recreate without worrying about audio continuity
-		}else{
-			Serial.println("Active playback detected - attempting seamless recreation");
-			// Need to be extra careful about timing
-		}
-		
-		// Mixer settings already stored at function start
-		
-		// Stop old system safely
-		if(system){
-			Serial.println("Stopping old MixSystem...");
-			
-			// Ensure all channels are fully stopped
-			system->pauseChannel(0);
-			system->pauseChannel(1);
-			delay(100); // Let channels stop completely
-			
-			system->stop();
-			delay(100); // Let system fully stop
-			
-			Serial.println("Deleting old MixSystem...");
-			MixSystem* oldSystem = system;
-			system = nullptr; // Clear pointer first to prevent use-after-free
-			
-			delete oldSystem;
-			Serial.printf("Post-delete memory: heap=%u\n", ESP.getFreeHeap());
-		}else{
-			Serial.println("No old MixSystem to delete");
-		}
-		
-		// POWER MANAGEMENT: Delay before creating new system
-		delay(100);
-		
-		// Create new system with both files
-		Serial.println("Creating new MixSystem...");
-		system = new MixSystem(f1, f2);
-		Serial.printf("New MixSystem created: %p\n", system);
-		Serial.printf("Post-create memory: heap=%u\n", ESP.getFreeHeap());
-		
-		// Restore VU meter connections first (safe to do immediately)
-		system->setChannelInfo(0, leftVu.getInfoGenerator());
-		system->setChannelInfo(1, rightVu.getInfoGenerator());
-		system->setChannelInfo(2, midVu.getInfoGenerator());
-		
-		// Update seek bars
-		if(f1){
-			leftSeekBar->setTotalDuration(system->getDuration(0));
-			leftSeekBar->setCurrentDuration(0);  // New tracks start at beginning
-			leftSeekBar->setPlaying(false);      // Will be updated below
-		}
-		if(f2){
-			rightSeekBar->setTotalDuration(system->getDuration(1));
-			rightSeekBar->setCurrentDuration(0);  // New tracks start at beginning
-			rightSeekBar->setPlaying(false);      // Will be updated below
-		}
-		
-		// Start new system
-		system->start();
-		
-		// Optimized stabilization delays for better audio continuity
-		// Shorter delays reduce audio dropouts during hot-swap
-		if(channel0WasPlaying && channel1WasPlaying){
-			Serial.println("Both channels were playing - using minimal dual-channel delay");
-			delay(200); // Reduced from 500ms for better continuity
-		}else if(channel0WasPlaying || channel1WasPlaying){
-			Serial.println("Single channel playing - using minimal delay");
-			delay(150); // Reduced from 350ms for better continuity
-		}else{
-			Serial.println("No channels playing - using standard delay");
-			delay(250); // Standard delay when no audio is playing
-		}
-		
-		Serial.println("System started, beginning state restoration...");
-		
-		// DJ-STYLE APPROACH: Clean pause all, preserve positions, let user control resume
-		// This works with MixSystem limitations rather than fighting them
-		
-		Serial.println("Post-recreation: DJ-style hot-swap - clean state with position memory");
-		
-		// Always pause both channels for clean state (prevent decode errors)
-		system->pauseChannel(0);
-		delay(100); // Longer delay between pauses
-		system->pauseChannel(1);
-		
-		// Optimized settlement delay - less aggressive for dual-channel scenarios
-		if(channel0WasPlaying && channel1WasPlaying){
-			Serial.println("Dual-channel scenario - using optimized delay");
-			delay(400); // Reduced to prevent timing issues
-		}else{
-			delay(300); // Reduced for single-channel scenarios
-		}
-		
-		// Additional decoder stability measures to prevent lockup and resets
-		Serial.println("Performing decoder stability check...");
-		
-		// Give more time for decoder to fully initialize with new files
-		delay(500);
-		
-		// Ensure both files are at the beginning for clean decoder state
-		if(f1 && f1.size() > 0) {
-			f1.seek(0);
-			Serial.printf("Reset f1 to position 0 (size: %d)\n", f1.size());
-		}
-		if(f2 && f2.size() > 0) {
-			f2.seek(0);
-			Serial.printf("Reset f2 to position 0 (size: %d)\n", f2.size());
-		}
-		
-		delay(200); // Additional stabilization time
-		
-		// Set seek bars to paused but preserve position information
-		leftSeekBar->setPlaying(false);
-		rightSeekBar->setPlaying(false);
-		
-		// Restore mixer settings AFTER system stabilization to prevent volume jumps
-		Serial.println("Restoring mixer settings after stabilization...");
-		system->setVolume(0, leftVol);
-		system->setVolume(1, rightVol);
-		
-		// Apply crossfader curve to stored mix value for consistent audio response
-		uint8_t curvedMixVal = applyCrossfaderCurve(mixVal);
-		system->setMix(curvedMixVal);
-		Serial.printf("Mixer settings restored: Vol L=%d, Vol R=%d, Mix=%d (curved: %d)\n", leftVol, rightVol, mixVal, curvedMixVal);
-		
-		// Store the positions in seek bars so user can see where they were
-		if(deck == 0){
-			// New track loaded to channel 0 (left deck)
-			Serial.println("Hot-swap: New track on LEFT deck, preserving RIGHT deck position");
-			
-			// New track starts at beginning
-			leftSeekBar->setCurrentDuration(0);
-			
-			// Preserve the position of the continuing track
-			if(f2 && f2.size() > 0 && channel1Position > 0){
-				rightSeekBar->setCurrentDuration(channel1Position);
-				// CRITICAL: Prevent loop from overwriting this preserved position
-				lastSmartSeekTime[1] = millis() - 1; // Set to recent time to activate protection
-				Serial.printf("RIGHT deck position preserved: %d seconds (press play to continue)\n", channel1Position);
-				Serial.printf("Verification: rightSeekBar now shows %d seconds\n", rightSeekBar->getCurrentDuration());
-			}
-		}else{
-			// New track loaded to channel 1 (right deck)  
-			Serial.println("Hot-swap: New track on RIGHT deck, preserving LEFT deck position");
-			
-			// New track starts at beginning
-			rightSeekBar->setCurrentDuration(0);
-			
-			// Preserve the position of the continuing track
-			if(f1 && f1.size() > 0 && channel0Position > 0){
-				leftSeekBar->setCurrentDuration(channel0Position);
-				// CRITICAL: Prevent loop from overwriting this preserved position
-				lastSmartSeekTime[0] = millis() - 1; // Set to recent time to activate protection
-				Serial.printf("LEFT deck position preserved: %d seconds (press play to continue)\n", channel0Position);
-				Serial.printf("Verification: leftSeekBar now shows %d seconds\n", leftSeekBar->getCurrentDuration());
-			}
-		}
-		
-		Serial.println("Hot-swap complete - DJ can now resume playback with precise control");
-		
-		Serial.printf("MixSystem updated successfully (new: %p)\n", system);
+	String name = deckFile.name();
+	String trackName = name.substring(name.lastIndexOf('/') + 1, name.length() - 4);
+	songName->setSongName(trackName);
+	Serial.printf("f%d hot-swapped to: %s\n", deck + 1, trackName.c_str());
+	
+	// Beat grids changed, the DJ has to sync again
+	if(tempoSync){
+		tempoSync->disengage();
 	}
+
+	// New track starts at the beginning, paused - the DJ decides when to drop it
+	seekBar->setTrack(name);
+	seekBar->setTotalDuration(getTrackDuration(deck, name.c_str()));
+	seekBar->setCurrentDuration(0);
+	seekBar->setPlaying(false);
+	
+	Serial.printf("Post-swap memory: heap=%u\n", ESP.getFreeHeap());
 	
 	// Reset flags after hot-swap completion
-	hotSwapInProgress = false; // Clear protection flag
+	hotSwapInProgress = false;
 	keepAudioOnStop = false;
 	justCompletedHotSwap = true;
-	
-	// Prevent any lingering loading states that could cause issues
 	isLoadingTrack = false;
 	
-	Serial.println("Hot-swap flags reset - system ready for normal operation");
-	
-	// Use stored hardware values (already validated when captured) instead of reading fresh
-	// Reading hardware values immediately after hot-swap can return corrupted data
-	Serial.println("Using stored hardware values (already validated during capture)...");
-	
-	// Apply stored hardware values to system to match hardware position when button was held
-	if(system){
-		system->setVolume(0, storedLeftVol);
-		system->setVolume(1, storedRightVol);
-		uint8_t curvedMixVal = applyCrossfaderCurve(storedMixVal);
-		system->setMix(curvedMixVal);
-		
-		// Update tracked values to match stored hardware values
-		lastValidLeftVol = storedLeftVol;
-		lastValidRightVol = storedRightVol;
-		lastValidMixVal = storedMixVal;
-		
-		Serial.printf("Applied stored hardware values: Vol L=%d, Vol R=%d, Mix=%d (curved: %d)\n", 
-			storedLeftVol, storedRightVol, storedMixVal, curvedMixVal);
-	}
-	
-	// Schedule auto-resume for the channel that WASN'T replaced (the continuing channel)
-	if(system){
-		if(deck == 0 && channel1WasPlaying && f2 && f2.size() > 0){
-			// Replaced Player 1 (deck 0), continue Player 2 (channel 1)
-			Serial.println("Scheduling auto-resume for player 2 (RIGHT) - continuing after Player 1 replacement");
-			pendingAutoResume = true;
-			pendingAutoResumeChannel = 1;
-			autoResumeScheduledTime = millis() + 400; // Reduced delay for faster continuity
-		}else if(deck == 1 && channel0WasPlaying && f1 && f1.size() > 0){
-			// Replaced Player 2 (deck 1), continue Player 1 (channel 0)
-			Serial.println("Scheduling auto-resume for player 1 (LEFT) - continuing after Player 2 replacement");
-			pendingAutoResume = true;
-			pendingAutoResumeChannel = 0;
-			autoResumeScheduledTime = millis() + 400; // Reduced delay for faster continuity
-		}else{
-			Serial.printf("No auto-resume scheduled: deck=%d, ch0Playing=%s, ch1Playing=%s\n", 
-				deck, channel0WasPlaying ? "true" : "false", channel1WasPlaying ? "true" : "false");
-		}
-	}
+	compositor.invalidate(getDeckLayout(deck));
 	
 	Serial.println("=== HOT-SWAP COMPLETE ===");
 }
@@ -1381,31 +1071,6 @@ void MixScreen::MixScreen::encBtnHold(uint8_t i){
 			system, hotSwapInProgress ? "true" : "false");
 		Serial.printf("Memory before SongList: heap=%u\n", ESP.getFreeHeap());
 		
-		// Capture hardware mixer values while system is stable
-		// For all pots, use the last known good values from potMove callbacks
-		// as getPotValue() can return corrupted data during system transitions
-		
-		// Use the last valid values tracked by potMove callbacks
-		storedLeftVol = lastValidLeftVol;
-		storedRightVol = lastValidRightVol;
-		storedMixVal = lastValidMixVal;
-		
-		// Fallback to direct reading only if we don't have tracked values
-		if(storedLeftVol == 0 && storedRightVol == 0 && storedMixVal == 0) {
-			Serial.println("No tracked values - attempting direct hardware read");
-			uint8_t rawLeftVol = InputJayD::getInstance()->getPotValue(POT_L);
-			uint8_t rawRightVol = InputJayD::getInstance()->getPotValue(POT_R);
-			uint8_t rawMixVal = InputJayD::getInstance()->getPotValue(POT_MID);
-			
-			// Validate direct readings
-			storedLeftVol = (rawLeftVol > 255) ? 128 : rawLeftVol;  // Default to mid-level
-			storedRightVol = (rawRightVol > 255) ? 128 : rawRightVol;
-			storedMixVal = (rawMixVal > 255) ? 128 : rawMixVal;
-		}
-		
-		Serial.printf("Captured hardware mixer values: Vol L=%d, Vol R=%d, Mix=%d (validated)\n", 
-			storedLeftVol, storedRightVol, storedMixVal);
-		
 		// Store which deck we're loading for
 		isLoadingTrack = true;
 		loadingDeck = selectedChannel;
@@ -1419,6 +1084,39 @@ void MixScreen::MixScreen::encBtnHold(uint8_t i){
 		Serial.println("=== SongList opened ===\n");
 		return;
 	}
+
+	// Holding a SPEED slot's encoder syncs that deck to the other one
+	if(timeline.isBusy()) return;
+	if(i < 6 && effectElements[i]->getType() == EffectType::SPEED){
+		toggleSync(i >= 3);
+	}
+}
+
+void MixScreen::MixScreen::toggleSync(uint8_t channel){
+	if(!system || !tempoSync) return;
+
+	if(tempoSync->isEngaged() && tempoSync->getFollower() == channel){
+		tempoSync->disengage();
+		return;
+	}
+
+	BeatInfo followerBeats;
+	BeatInfo masterBeats;
+	if(!getBeatInfo(channel, followerBeats) || !getBeatInfo(!channel, masterBeats)){
+		Serial.println("SYNC: both decks need an analyzed tempo");
+		return;
+	}
+
+	if(!tempoSync->engage(channel, followerBeats, masterBeats)) return;
+
+	// Show the nearest encoder step on the speed slot, the applied ratio is exact
+	for(int i = channel * 3; i < channel * 3 + 3; i++){
+		if(effectElements[i]->getType() != EffectType::SPEED) continue;
+
+		float intensity = 128.0f + 128.0f * log2f(tempoSync->getRatio());
+		effectElements[i]->setIntensity(constrain((int) roundf(intensity), 0, 255));
+		compositor.invalidate(effectElements[i]);
+	}
 }
 
 void MixScreen::MixScreen::initializeDefaultEffects(){
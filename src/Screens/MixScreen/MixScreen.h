@@ -7,7 +7,13 @@
 #include "SongName.h"
 #include "EffectElement.h"
 #include "MatrixPopUpPicker.h"
-#include <AudioLib/Systems/MixSystem.h>
+#include "../../Audio/DeckMixer.h"
+#include "../../Audio/TempoSync.h"
+#include "../../Util/Timeline.h"
+#include "../../Render/Compositor.h"
+#include "../../Render/BackgroundLayer.h"
+#include "../../Render/FrameScheduler.h"
+#include "../../Library/BeatAnalyzer.h"
 #include <Matrix/VuVisualizer.h>
 #include <Matrix/RoundVuVisualiser.h>
 #include <Input/InputJayD.h>
@@ -35,13 +41,18 @@ namespace MixScreen {
 		void unpack() override;
 		void setBigVuStarted(bool bigVuStarted);
 
+		// Analyzed tempo and beat grid of the track on a deck, false until the analyzer has it
+		bool getBeatInfo(uint8_t channel, BeatInfo& info);
+
 	private:
 		static MixScreen* instance;
 
 		fs::File f1;
 		fs::File f2;
 		Color *selectedBackgroundBuffer = nullptr;
-		MixSystem* system = nullptr;
+		DeckMixer* system = nullptr;
+		TempoSync* tempoSync = nullptr;
+		void toggleSync(uint8_t channel);
 
 		LinearLayout* screenLayout;
 		LinearLayout* leftLayout;
@@ -66,7 +77,18 @@ namespace MixScreen {
 
 
 		uint32_t lastDraw = 0;
-		bool drawQueued = false;
+
+		// Only the parts of the screen that changed since the last frame go out to the panel
+		Compositor compositor;
+
+		// Deck panels and the selection border, they only change when the selected deck does
+		BackgroundLayer background;
+
+		// Recording writes to the card on the audio thread, the screen slows down to leave it the bus
+		FrameScheduler scheduler;
+		static const uint8_t Fps = 20;
+		static const uint8_t RecordingFps = 5;
+		LinearLayout* getDeckLayout(uint8_t channel) const;
 
 		uint32_t seekTime = 0;
 		bool wasRunning = false;
@@ -86,29 +108,19 @@ namespace MixScreen {
 		bool hotSwapInProgress = false;
 		bool justCompletedHotSwap = false;
 		
-		// Smart resume timing
-		uint32_t lastSmartSeekTime[2] = {0, 0}; // Track last seek time for each channel
-		
-		// Auto-resume after hot-swap
-		bool pendingAutoResume = false;
-		uint8_t pendingAutoResumeChannel = 0;
-		uint32_t autoResumeScheduledTime = 0;
-		
-		// Stored hardware mixer values for hot-swap
-		uint8_t storedLeftVol = 200;
-		uint8_t storedRightVol = 200;
-		uint8_t storedMixVal = 128;
-		
-		// Track last known good hardware values from potMove callbacks
-		uint8_t lastValidLeftVol = 200;
-		uint8_t lastValidRightVol = 200;
-		uint8_t lastValidMixVal = 128;
+		uint32_t analyzerGeneration = 0;
+
+		// Timed multi-step deck operations (mixer startup) run from here instead of delay()
+		Timeline timeline;
 
 		void startBigVu();
 		void stopBigVu();
 		void hotSwapTrack(uint8_t deck, fs::File newFile);
+
+		// Length of the track on deck as the deck measured it (exact with a seek index), the length
+		// stored in the song index when the deck has none
+		uint16_t getTrackDuration(uint8_t deck, const char* path);
 		
-		uint8_t applyCrossfaderCurve(uint8_t rawValue);
 		void initializeDefaultEffects();
 
 		void potMove(uint8_t id, uint8_t value) override;
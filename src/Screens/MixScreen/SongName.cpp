@@ -6,37 +6,17 @@ MixScreen::SongName::SongName(ElementContainer *parent) : CustomElement(parent,
 }
 
 void MixScreen::SongName::draw(){
-
 	auto canvas = getSprite();
-	canvas->setFont(&u8g2_font_HelvetiPixel_tr);
-	canvas->setTextColor(TFT_WHITE);
-
-
 
 	if(scrolling){
-		String temp = songName;
-		while(scrollCursor + (nameLength - canvas->textWidth(temp.c_str())) < 0){
-			temp.remove(0, 1);
-		}
-		int32_t correctedCursor = scrollCursor + (nameLength - canvas->textWidth(temp.c_str()));
-		while(correctedCursor + canvas->textWidth(temp.c_str()) >= (int)(getWidth())){
-			temp.remove(temp.length() - 1);
-		}
-
-		canvas->drawString(temp, getTotalX() + correctedCursor, getTotalY() - 6);
-
-		temp = songName;
-		if(scrollCursor + scrollOffset + nameLength > getWidth()) return;
-		while((scrollCursor + scrollOffset + nameLength) + (nameLength - canvas->textWidth(temp.c_str())) < 0 && temp.length() > 0){
-			temp.remove(0, 1);
-		}
-		correctedCursor = (scrollCursor + scrollOffset + nameLength) + (nameLength - canvas->textWidth(temp.c_str()));
-		while(correctedCursor + canvas->textWidth(temp.c_str()) >= (int)(getWidth()) && temp.length() > 0){
-			temp.remove(temp.length() - 1);
-		}
-
-		canvas->drawString(temp, getTotalX() + correctedCursor, getTotalY() - 6);
+		// Two copies of the pre-rendered name chase each other through the box
+		int32_t x = getTotalX() + scrollCursor;
+		int32_t y = getTotalY() - 6;
+		strip.draw(canvas, x, y, getTotalX(), getWidth() - 1);
+		strip.draw(canvas, x + nameLength + scrollOffset, y, getTotalX(), getWidth() - 1);
 	}else{
+		canvas->setFont(&u8g2_font_HelvetiPixel_tr);
+		canvas->setTextColor(TFT_WHITE);
 		canvas->drawString(songName, getTotalX() + scrollCursor, getTotalY() - 6);
 	}
 }
@@ -52,6 +32,8 @@ bool MixScreen::SongName::checkScrollUpdate(){
 		}
 		return true;
 	}
+
+	return false;
 }
 
 void MixScreen::SongName::setSongName(const String& songName){
@@ -63,10 +45,12 @@ void MixScreen::SongName::setSongName(const String& songName){
 
 	nameLength = canvas->textWidth(songName.c_str());
 	if(nameLength >= (getWidth() - 2)){
+		strip.set(songName, &u8g2_font_HelvetiPixel_tr, TFT_WHITE);
 		scrolling = true;
 		currentTime = millis();
 		scrollCursor = 10;
 	}else{
+		strip.clear();
 		scrolling = false;
 		scrollCursor = ((int)(getWidth()) - 2 - nameLength) / 2;
 	}
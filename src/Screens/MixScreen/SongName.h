@@ -2,6 +2,7 @@
 #define JAYD_FIRMWARE_MIX_SONGNAME_H
 
 #include <UI/CustomElement.h>
+#include "../../Render/TextStrip.h"
 
 namespace MixScreen {
 	class SongName : public CustomElement {
@@ -15,6 +16,7 @@ namespace MixScreen {
 
 	private:
 		String songName = "";
+		TextStrip strip;
 		bool scrolling = false;
 		const int32_t scrollSpeed = 33; //in milliseconds (3x faster)
 		uint32_t currentTime = 0;
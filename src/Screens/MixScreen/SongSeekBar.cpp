@@ -1,6 +1,7 @@
 #include "SongSeekBar.h"
 #include <FS.h>
 #include <SPIFFS.h>
+#include <SD.h>
 
 MixScreen::SongSeekBar::SongSeekBar(ElementContainer *parent) : CustomElement(parent, 10, 10){
 	const char* const playPausePaths[] = {
@@ -45,7 +46,17 @@ void MixScreen::SongSeekBar::draw(){
 	getSprite()->printf("%02d:%02d", totalDuration / 60, totalDuration - (totalDuration / 60) * 60);
 
 	getSprite()->fillRoundRect(getTotalX() + 3, getTotalY() + 40, 72, 10, 2, TFT_BLACK);
-	getSprite()->fillRect(getTotalX() + 3, getTotalY() + 44, 72, 2, C_RGB(4, 211, 35));
+	if(waveform.isLoaded()){
+		// Peak envelope with the RMS body on top, mirrored around the middle of the bar
+		for(uint8_t i = 0; i < Waveform::Columns; i++){
+			uint8_t peak = (waveform.getPeak(i) * 4 + 254) / 255;
+			uint8_t rms = (waveform.getRMS(i) * 4 + 254) / 255;
+			getSprite()->drawFastVLine(getTotalX() + 3 + i, getTotalY() + 45 - peak, peak * 2, C_RGB(2, 110, 18));
+			getSprite()->drawFastVLine(getTotalX() + 3 + i, getTotalY() + 45 - rms, rms * 2, C_RGB(4, 211, 35));
+		}
+	}else{
+		getSprite()->fillRect(getTotalX() + 3, getTotalY() + 44, 72, 2, C_RGB(4, 211, 35));
+	}
 	getSprite()->drawRoundRect(getTotalX() + 3, getTotalY() + 40, 72, 10, 2, TFT_WHITE);
 	if(currentDuration==0){
 		movingCursor=0;
@@ -81,6 +92,32 @@ int MixScreen::SongSeekBar::getTotalDuration() const{
 	return totalDuration;
 }
 
+void MixScreen::SongSeekBar::setTrack(const String& path){
+	// A hot-swapped deck still has the previous track's overview loaded
+	if(path != trackPath){
+		waveform.clear();
+	}
+
+	trackPath = path;
+	reloadWaveform();
+}
+
+void MixScreen::SongSeekBar::clearTrack(){
+	trackPath = "";
+	waveform.clear();
+}
+
+bool MixScreen::SongSeekBar::reloadWaveform(){
+	if(waveform.isLoaded() || trackPath.length() == 0) return false;
+
+	fs::File track = SD.open(trackPath);
+	if(!track) return false;
+
+	bool loaded = waveform.load(track);
+	track.close();
+	return loaded;
+}
+
 bool MixScreen::SongSeekBar::isPlaying() const{
 	return playing;
 }
@@ -2,6 +2,7 @@
 #define JAYD_FIRMWARE_SONGSEEKBAR_H
 
 #include <UI/CustomElement.h>
+#include "../../Library/Waveform.h"
 
 namespace MixScreen {
 	class SongSeekBar : public CustomElement {
@@ -21,12 +22,20 @@ namespace MixScreen {
 		int getCurrentDuration() const;
 		int getTotalDuration() const;
 
+		// Shows the cached waveform overview of the track, or a flat line until it has been analyzed
+		void setTrack(const String& path);
+		void clearTrack();
+		bool reloadWaveform();
+
 	private:
 		bool playing = false;
 		int totalDuration = 0;
 		int currentDuration = 0;
 		float movingCursor=0;
 
+		String trackPath;
+		Waveform waveform;
+
 		Color *playPause[2] = { nullptr };
 	};
 
@@ -4,6 +4,7 @@
 #include <Loop/LoopManager.h>
 #include "Playback.h"
 #include "../MainMenu/MainMenu.h"
+#include "../../Library/SongScanner.h"
 #include <SPIFFS.h>
 #include <FS/CompressedFile.h>
 
@@ -13,7 +14,7 @@ Playback::Playback::Playback(Display& display) : Context(display), screenLayout(
 												 songNameLayout(new LinearLayout(screenLayout, HORIZONTAL)),
 												 timeElapsedLayout(new LinearLayout(screenLayout, HORIZONTAL)), buttonLayout(new LinearLayout(
 				screenLayout, HORIZONTAL)), songName(new SongName(songNameLayout)), playOrPause(new PlayPause(buttonLayout)),
-												 trackCount(new TrackCounter(timeElapsedLayout)){
+												 trackCount(new TrackCounter(timeElapsedLayout)), background(screen), scheduler("Playback", Fps){
 
 
 	instance = this;
@@ -49,14 +50,19 @@ void Playback::Playback::loop(uint micros){
 		trackCount->setTotalDuration(system->getDuration());
 	}
 
-	uint32_t currentTime = millis();
-	if((update || drawQueued) && (currentTime - lastDraw) >= 100){
-		drawQueued = false;
+	bool ended = !system->isRunning() || (system->getDuration() != 0 && system->getElapsed() >= system->getDuration());
+	if(playing && queue.isOpen() && seekTime == 0 && ended){
+		playNext();
+		return;
+	}
+
+	if(update){
+		scheduler.invalidate();
+	}
+	scheduler.run([this](){
 		draw();
 		screen.commit();
-	}else if(update){
-		drawQueued = true;
-	}
+	});
 }
 
 void Playback::Playback::returned(void *data){
@@ -68,10 +74,20 @@ void Playback::Playback::returned(void *data){
 
 void Playback::Playback::start(){
 	if(!file){
-		(new SongList::SongList(*screen.getDisplay()))->push(this);
+		auto songList = new SongList::SongList(*screen.getDisplay());
+		songList->setQueue(&queue);
+		songList->push(this);
 		return;
 	}
 
+	startTrack();
+
+	Input.addListener(this);
+	InputJayD::getInstance()->addListener(this);
+	LoopManager::addListener(this);
+}
+
+void Playback::Playback::startTrack(){
 	String name = file.name();
 	songName->setSongName(name.substring(name.lastIndexOf('/') + 1, name.length() - 4));
 	trackCount->setTotalDuration(0);
@@ -95,12 +111,40 @@ void Playback::Playback::start(){
 	system->setVolume(InputJayD::getInstance()->getPotValue(POT_MID));
 	system->start();
 
+	playing = true;
 	playOrPause->setPlaying(true);
+}
 
-	Input.addListener(this);
-	InputJayD::getInstance()->addListener(this);
-	LoopManager::addListener(this);
-	lastDraw = 0;
+void Playback::Playback::playNext(){
+	// The scanner swaps the index tables when it's done, the next track is looked up once it's idle
+	if(Scanner.isRunning()) return;
+
+	// Entries that were deleted from the card since they were added get skipped
+	fs::File next;
+	String path;
+	while(!next && (path = queue.next()).length() != 0){
+		next = SD.open(path);
+	}
+
+	if(!next){
+		Serial.printf("Playback: end of crate %s\n", queue.getName().c_str());
+		queue.close();
+		system->stop();
+		playing = false;
+		playOrPause->setPlaying(false);
+		scheduler.invalidate();
+		return;
+	}
+
+	Serial.printf("Playback: next in %s - %s\n", queue.getName().c_str(), path.c_str());
+
+	system->stop();
+	delete system;
+	system = nullptr;
+	file.close();
+
+	file = next;
+	startTrack();
 }
 
 void Playback::Playback::stop(){
@@ -121,7 +165,15 @@ void Playback::Playback::stop(){
 
 
 void Playback::Playback::draw(){
-	screen.getSprite()->drawIcon(backgroundBuffer, 0, 0, 160, 128, 1);
+	if(!background.restore()){
+		screen.getSprite()->drawIcon(backgroundBuffer, 0, 0, 160, 128, 1);
+
+		// The decoded picture is only needed until it's cached
+		if(background.capture()){
+			free(backgroundBuffer);
+			backgroundBuffer = nullptr;
+		}
+	}
 	screen.draw();
 }
 
@@ -163,6 +215,7 @@ void Playback::Playback::pack(){
 	Context::pack();
 	free(backgroundBuffer);
 	backgroundBuffer = nullptr;
+	background.release();
 }
 
 void Playback::Playback::unpack(){
@@ -205,7 +258,7 @@ void Playback::Playback::btnEnc(uint8_t i) {
 			playing = true;
 		}
 		playOrPause->setPlaying(playing);
-		drawQueued = true;
+		scheduler.invalidate();
 	}
 }
 
@@ -221,7 +274,7 @@ void Playback::Playback::enc(uint8_t id, int8_t value) {
 		uint16_t seekTime = constrain(trackCount->getCurrentDuration() + value, 0, system->getDuration());
 		trackCount->setCurrentDuration(seekTime);
 
-		drawQueued = true;
+		scheduler.invalidate();
 	}
 }
 
@@ -9,6 +9,9 @@
 #include "PlayPause.h"
 #include "TrackCounter.h"
 #include "../SongList/SongList.h"
+#include "../../Library/Crate.h"
+#include "../../Render/BackgroundLayer.h"
+#include "../../Render/FrameScheduler.h"
 #include <FS.h>
 #include <AudioLib/OutputI2S.h>
 #include <AudioLib/SourceWAV.h>
@@ -54,10 +57,16 @@ namespace Playback {
 		PlaybackSystem* system = nullptr;
 		bool playing = false;
 
+		// Rest of the crate the track was picked from, played in order when a track ends
+		Crate queue;
+		void startTrack();
+		void playNext();
+
 		Color *backgroundBuffer = nullptr;
+		BackgroundLayer background;
 
-		uint32_t lastDraw = 0;
-		bool drawQueued = false;
+		FrameScheduler scheduler;
+		static const uint8_t Fps = 10;
 
 		uint32_t seekTime = 0;
 		bool wasRunning = false;
@@ -27,6 +27,17 @@ void SettingsScreen::DropDownElement::selectPrev(){
 	index = max(index, 0);
 }
 
+int SettingsScreen::DropDownElement::getIndex() const{
+	return index;
+}
+
+void SettingsScreen::DropDownElement::setIndex(int index){
+	if(dropDownContent.empty()){
+		return;
+	}
+	DropDownElement::index = constrain(index, 0, (int) dropDownContent.size() - 1);
+}
+
 void SettingsScreen::DropDownElement::drawControl(){
 	getSprite()->setTextColor(TFT_BLACK);
 	getSprite()->setTextSize(1);
@@ -15,6 +15,10 @@ namespace SettingsScreen {
 
 		void selectPrev();
 
+		int getIndex() const;
+
+		void setIndex(int index);
+
 	private:
 
 		bool showDropDown = false;
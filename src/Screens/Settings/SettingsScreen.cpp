@@ -6,13 +6,20 @@
 #include <Settings.h>
 #include <JayD.h>
 #include <AudioLib/Systems/PlaybackSystem.h>
+#include "../../MixSettings.h"
+#include <Loop/LoopManager.h>
 
 SettingsScreen::SettingsScreen* SettingsScreen::SettingsScreen::instance = nullptr;
 
 SettingsScreen::SettingsScreen::SettingsScreen(Display &display) : Context(display), screenLayout(new LinearLayout(&screen, VERTICAL)),
 																   volumeSlider(new SliderElement(screenLayout, "Volume")), brightnessSlider(new SliderElement(screenLayout, "Brightness")),
+																   crossfadeCurve(new DropDownElement(screenLayout, "Crossfader", {
+																		   CrossfadeCurve::getName(LINEAR),
+																		   CrossfadeCurve::getName(CONSTANT_POWER),
+																		   CrossfadeCurve::getName(SCRATCH),
+																		   CrossfadeCurve::getName(SMOOTH) })),
 																   inputTest(new TextElement(screenLayout, "Input Test")),
-																   saveSettings(new TextElement(screenLayout, "Save")){
+																   saveSettings(new TextElement(screenLayout, "Save")), background(screen), scheduler("Settings", Fps){
 
 	instance = this;
 	buildUI();
@@ -23,6 +30,8 @@ SettingsScreen::SettingsScreen::SettingsScreen(Display &display) : Context(displ
 
 	brightnessSlider->setSliderValue(Settings.get().brightnessLevel);
 
+	crossfadeCurve->setIndex(MixSettings.get().crossfadeCurve);
+
 	SettingsScreen::pack();
 }
 
@@ -35,8 +44,7 @@ void SettingsScreen::SettingsScreen::start(){
 			instance->volumeSlider->moveSliderValue(value);
 			Settings.get().volumeLevel = instance->volumeSlider->getSliderValue();
 			instance->playback->updateGain();
-			instance->draw();
-			instance->screen.commit();
+			instance->scheduler.invalidate();
 			return;
 		}
 		if(instance->disableMainSelector && instance->selectedSetting == 1){
@@ -44,15 +52,23 @@ void SettingsScreen::SettingsScreen::start(){
 			Settings.get().brightnessLevel = instance->brightnessSlider->getSliderValue();
 			LEDmatrix.setBrightness(80.0f * (float) instance->brightnessSlider->getSliderValue() / 255.0f);
 			matrixManager.push();
-			instance->draw();
-			instance->screen.commit();
+			instance->scheduler.invalidate();
+			return;
+		}
+		if(instance->disableMainSelector && instance->selectedSetting == 2){
+			if(value > 0){
+				instance->crossfadeCurve->selectNext();
+			}else{
+				instance->crossfadeCurve->selectPrev();
+			}
+			instance->scheduler.invalidate();
 			return;
 		}
 		instance->selectedSetting = instance->selectedSetting + value;
 
 		if(instance->selectedSetting < 0){
-			instance->selectedSetting = 3;
-		}else if(instance->selectedSetting > 3){
+			instance->selectedSetting = 4;
+		}else if(instance->selectedSetting > 4){
 			instance->selectedSetting = 0;
 		}
 		if(instance->selectedSetting == 0){
@@ -68,19 +84,24 @@ void SettingsScreen::SettingsScreen::start(){
 			instance->brightnessSlider->setIsSelected(false);
 		}
 		if(instance->selectedSetting == 2){
+			instance->crossfadeCurve->setIsSelected(true);
+
+		}else{
+			instance->crossfadeCurve->setIsSelected(false);
+		}
+		if(instance->selectedSetting == 3){
 			instance->inputTest->setIsSelected(true);
 
 		}else{
 			instance->inputTest->setIsSelected(false);
 		}
-		if(instance->selectedSetting == 3){
+		if(instance->selectedSetting == 4){
 			instance->saveSettings->setIsSelected(true);
 
 		}else{
 			instance->saveSettings->setIsSelected(false);
 		}
-		instance->draw();
-		instance->screen.commit();
+		instance->scheduler.invalidate();
 	});
 	InputJayD::getInstance()->setBtnPressCallback(BTN_MID, [](){
 		if(instance == nullptr) return;
@@ -88,8 +109,7 @@ void SettingsScreen::SettingsScreen::start(){
 
 			instance->volumeSlider->toggle();
 			instance->disableMainSelector = !instance->disableMainSelector;
-			instance->draw();
-			instance->screen.commit();
+			instance->scheduler.invalidate();
 			if(instance->disableMainSelector) {
 				Settings.get().volumeLevel = instance->volumeSlider->getSliderValue();
 				instance->playback->updateGain();
@@ -106,19 +126,26 @@ void SettingsScreen::SettingsScreen::start(){
 			}else{
 				matrixManager.stopRandom();
 			}
-			instance->draw();
-			instance->screen.commit();
+			instance->scheduler.invalidate();
 		}else if(instance->selectedSetting == 2){
+			instance->crossfadeCurve->toggle();
+			instance->disableMainSelector = !instance->disableMainSelector;
+			if(!instance->disableMainSelector){
+				MixSettings.get().crossfadeCurve = instance->crossfadeCurve->getIndex();
+			}
+			instance->scheduler.invalidate();
+		}else if(instance->selectedSetting == 3){
 			Display &display = *instance->getScreen().getDisplay();
 			InputTest::InputTest *inputTest = new InputTest::InputTest(display);
 			inputTest->push(instance);
-		}else if(instance->selectedSetting == 3){
+		}else if(instance->selectedSetting == 4){
 			instance->pop();
 		}
 
 	});
 	instance->draw();
 	instance->screen.commit();
+	LoopManager::addListener(this);
 	introSong = SPIFFS.open("/intro.aac");
 	playback = new PlaybackSystem(introSong);
 	Settings.get().volumeLevel = instance->volumeSlider->getSliderValue();
@@ -127,29 +154,46 @@ void SettingsScreen::SettingsScreen::start(){
 }
 
 void SettingsScreen::SettingsScreen::stop(){
+	LoopManager::removeListener(this);
 	InputJayD::getInstance()->removeEncoderMovedCallback(0);
 	InputJayD::getInstance()->removeBtnPressCallback(2);
 	matrixManager.stopRandom();
 	Settings.store();
+	MixSettings.store();
 	playback->stop();
 	introSong.close();
 	delete playback;
 }
 
+void SettingsScreen::SettingsScreen::loop(uint micros){
+	scheduler.run([this](){
+		draw();
+		screen.commit();
+	});
+}
+
 void SettingsScreen::SettingsScreen::draw(){
-	screen.getSprite()->drawIcon(backgroundBuffer, 0, 0, 160, 128, 1);
-	screen.getSprite()->setTextColor(TFT_WHITE);
-	screen.getSprite()->setTextSize(1);
-	screen.getSprite()->setTextFont(1);
-	screen.getSprite()->setCursor(screenLayout->getTotalX() + 42, screenLayout->getTotalY() + 115);
-	screen.getSprite()->println("Version 1.3");
-
-	for(int i = 0; i < 4; i++){
+	// Background and version line never change, they're drawn once and restored from the cache after
+	if(!background.restore()){
+		screen.getSprite()->drawIcon(backgroundBuffer, 0, 0, 160, 128, 1);
+		screen.getSprite()->setTextColor(TFT_WHITE);
+		screen.getSprite()->setTextSize(1);
+		screen.getSprite()->setTextFont(1);
+		screen.getSprite()->setCursor(screenLayout->getTotalX() + 42, screenLayout->getTotalY() + 115);
+		screen.getSprite()->println("Version 1.3");
+
+		if(background.capture()){
+			free(backgroundBuffer);
+			backgroundBuffer = nullptr;
+		}
+	}
+
+	for(int i = 0; i < 5; i++){
 		if(!reinterpret_cast<SettingsElement *>(screenLayout->getChild(i))->isSelected()){
 			screenLayout->getChild(i)->draw();
 		}
 	}
-	for(int i = 0; i < 4; i++){
+	for(int i = 0; i < 5; i++){
 		if(reinterpret_cast<SettingsElement *>(screenLayout->getChild(i))->isSelected()){
 			screenLayout->getChild(i)->draw();
 		}
@@ -162,6 +206,7 @@ void SettingsScreen::SettingsScreen::pack(){
 	Context::pack();
 	free(backgroundBuffer);
 	backgroundBuffer = nullptr;
+	background.release();
 }
 
 void SettingsScreen::SettingsScreen::unpack(){
@@ -181,9 +226,10 @@ void SettingsScreen::SettingsScreen::unpack(){
 
 void SettingsScreen::SettingsScreen::buildUI(){
 	screenLayout->setWHType(PARENT, PARENT);
-	screenLayout->setGutter(5);
+	screenLayout->setGutter(2);
 	screenLayout->addChild(volumeSlider);
 	screenLayout->addChild(brightnessSlider);
+	screenLayout->addChild(crossfadeCurve);
 	screenLayout->addChild(inputTest);
 	screenLayout->addChild(saveSettings);
 
@@ -6,12 +6,16 @@
 #include "SettingsElement.h"
 #include "SliderElement.h"
 #include "TextElement.h"
+#include "DropDownElement.h"
 #include <FS.h>
+#include "../../Render/BackgroundLayer.h"
+#include "../../Render/FrameScheduler.h"
+#include <Loop/LoopListener.h>
 
 class PlaybackSystem;
 
 namespace SettingsScreen {
-	class SettingsScreen : public Context {
+	class SettingsScreen : public Context, public LoopListener {
 	public:
 
 		SettingsScreen(Display &display);
@@ -22,6 +26,8 @@ namespace SettingsScreen {
 
 		void draw();
 
+		void loop(uint micros) override;
+
 		void pack() override;
 
 		void unpack() override;
@@ -35,6 +41,7 @@ namespace SettingsScreen {
 
 		SliderElement* volumeSlider;
 		SliderElement* brightnessSlider;
+		DropDownElement* crossfadeCurve;
 		TextElement* inputTest;
 		TextElement* saveSettings;
 		int selectedSetting = 0;
@@ -45,6 +52,11 @@ namespace SettingsScreen {
 
 
 		Color* backgroundBuffer= nullptr;
+		BackgroundLayer background;
+
+		// Encoder callbacks only mark the screen, it's redrawn from loop()
+		FrameScheduler scheduler;
+		static const uint8_t Fps = 30;
 
 		PlaybackSystem* playback = nullptr;
 		fs::File introSong;
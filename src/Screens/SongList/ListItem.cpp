@@ -1,20 +1,46 @@
 #include "ListItem.h"
 #include "../../Fonts.h"
+#include "../../Library/BeatAnalyzer.h"
 
-SongList::ListItem::ListItem(ElementContainer *parent, String songName) : CustomElement(parent, 150, 15), songName(songName), path(songName){
+SongList::ListItem::ListItem(ElementContainer *parent, String songName) : CustomElement(parent, 150, 15){
+	bind(songName);
+}
+
+bool SongList::ListItem::setPath(const String& path){
+	if(path == this->path) return false;
 
-	this->songName = songName.substring(songName.lastIndexOf('/') + 1, songName.lastIndexOf('.'));
+	bind(path);
+	return true;
+}
+
+bool SongList::ListItem::setDuration(uint16_t duration){
+	if(duration == this->duration) return false;
+
+	// Name column width depends on it
+	this->duration = duration;
+	bind(path);
+	return true;
+}
+
+void SongList::ListItem::bind(const String& path){
+	if(path != this->path){
+		bpmChecked = false;
+	}
+	this->path = path;
+	songName = path.substring(path.lastIndexOf('/') + 1, path.lastIndexOf('.'));
 
 	auto canvas = getSprite();
 	canvas->setFont(&u8g2_font_profont12_tf);
 	canvas->setTextColor(TFT_WHITE);
 
-	nameLength = canvas->textWidth(this->songName.c_str());
+	nameLength = canvas->textWidth(songName.c_str());
 	scrollCursor = 2;
-	if(nameLength >= (getWidth() - 4)){
+	if(nameLength >= (nameWidth() - 4)){
+		strip.set(songName, &u8g2_font_profont12_tf, TFT_WHITE);
 		scrolling = true;
 		currentTime = millis();
 	}else{
+		strip.clear();
 		scrolling = false;
 	}
 }
@@ -29,33 +55,61 @@ void SongList::ListItem::draw(){
 	if(selected) {
 		getSprite()->drawRect(getTotalX() - 2, getTotalY() - 4, getWidth() + 4, getHeight() + 6, TFT_LIGHTGREY);//treba ubaciti ikonicu za scrolanje
 	}
-	if(scrolling && selected){
-		String temp = songName;
-		while(scrollCursor + (nameLength - canvas->textWidth(temp.c_str())) < 2){
-			temp.remove(0, 1);
-		}
-		int32_t correctedCursor = scrollCursor + (nameLength - canvas->textWidth(temp.c_str()));
-		while(correctedCursor + canvas->textWidth(temp.c_str()) >= (int)(getWidth() - 2)){
-			temp.remove(temp.length() - 1);
-		}
-		canvas->drawString(temp, getTotalX() + correctedCursor, getTotalY() + 9);
 
-		temp = songName;
-		if(scrollCursor + scrollOffset + nameLength > getWidth() - 2) return;
-		while((scrollCursor + scrollOffset + nameLength) + (nameLength - canvas->textWidth(temp.c_str())) < 2 && temp.length() > 0){
-			temp.remove(0, 1);
-		}
-		correctedCursor = (scrollCursor + scrollOffset + nameLength) + (nameLength - canvas->textWidth(temp.c_str()));
-		while(correctedCursor + canvas->textWidth(temp.c_str()) >= (int)(getWidth() - 2) && temp.length() > 0){
-			temp.remove(temp.length() - 1);
-		}
+	drawBPM();
+	drawDuration();
+
+	if(scrolling){
+		// Long names are blitted from their strip, scrolling on the selected row and cut before the tempo column on the others
+		int32_t y = getTotalY() + 9 - strip.getHeight() / 2;
+		int32_t clipX = getTotalX() + 2;
+		int32_t clipWidth = nameWidth() - 4;
 
-		canvas->drawString(temp, getTotalX() + correctedCursor, getTotalY() + 9);
+		strip.draw(canvas, getTotalX() + scrollCursor, y, clipX, clipWidth);
+		if(selected){
+			strip.draw(canvas, getTotalX() + scrollCursor + nameLength + scrollOffset, y, clipX, clipWidth);
+		}
 	}else{
 		canvas->drawString(songName, getTotalX() + scrollCursor, getTotalY() + 9);
 	}
 }
 
+void SongList::ListItem::drawBPM(){
+	if(!bpmChecked || bpmGeneration != Beats.getGeneration()){
+		bpmChecked = true;
+		bpmGeneration = Beats.getGeneration();
+
+		BeatInfo info;
+		bpm = Beats.get(path, info) ? (uint16_t) (info.bpm + 0.5f) : 0;
+	}
+	if(bpm == 0) return;
+
+	auto canvas = getSprite();
+	canvas->setTextDatum(CR_DATUM);
+	canvas->setTextColor(TFT_LIGHTGREY);
+	canvas->drawString(String(bpm), getTotalX() + getWidth() - 2, getTotalY() + 9);
+	canvas->setTextColor(TFT_WHITE);
+	canvas->setTextDatum(CL_DATUM);
+}
+
+void SongList::ListItem::drawDuration(){
+	if(duration == 0) return;
+
+	char text[8];
+	snprintf(text, sizeof(text), "%u:%02u", duration / 60, duration % 60);
+
+	auto canvas = getSprite();
+	canvas->setTextDatum(CR_DATUM);
+	canvas->setTextColor(TFT_LIGHTGREY);
+	canvas->drawString(text, getTotalX() + getWidth() - bpmWidth - 2, getTotalY() + 9);
+	canvas->setTextColor(TFT_WHITE);
+	canvas->setTextDatum(CL_DATUM);
+}
+
+int32_t SongList::ListItem::nameWidth() const{
+	return getWidth() - bpmWidth - (duration != 0 ? durationWidth : 0);
+}
+
 void SongList::ListItem::setSelected(bool selected){
 	ListItem::selected = selected;
 	if(!scrolling) return;
@@ -65,6 +119,10 @@ void SongList::ListItem::setSelected(bool selected){
 	}
 }
 
+bool SongList::ListItem::isSelected() const{
+	return selected;
+}
+
 const String& SongList::ListItem::getName() const{
 	return songName;
 }
@@ -80,6 +138,8 @@ bool SongList::ListItem::checkScrollUpdate(){
 		}
 		return true;
 	}
+
+	return false;
 }
 
 const String& SongList::ListItem::getPath() const{
@@ -2,6 +2,7 @@
 #define JAYD_FIRMWARE_LISTITEM_H
 
 #include <UI/CustomElement.h>
+#include "../../Render/TextStrip.h"
 
 namespace SongList {
 	class ListItem : public CustomElement {
@@ -10,7 +11,14 @@ namespace SongList {
 
 		void draw();
 
+		// Rebinds the row to another track, returns false if it already shows path
+		bool setPath(const String& path);
+
+		// Track length in seconds from the song index, 0 hides it. Returns false if it didn't change.
+		bool setDuration(uint16_t duration);
+
 		void setSelected(bool selected);
+		bool isSelected() const;
 
 		const String& getName() const;
 		const String& getPath() const;
@@ -21,13 +29,30 @@ namespace SongList {
 		bool selected = false;
 		String songName;
 		String path;
+		uint16_t duration = 0;
+
+		// Looked up again when the path or the analyzer's results change, the lookup stats the file
+		uint16_t bpm = 0;
+		uint32_t bpmGeneration = 0;
+		bool bpmChecked = false;
 
+		// Only long names get one, they're the ones that scroll or get cut
+		TextStrip strip;
 		bool scrolling = false;
 		const int32_t scrollSpeed = 33; //in milliseconds (3x faster)
 		uint32_t currentTime = 0;
 		int32_t nameLength;
 		int32_t scrollCursor = 0;
 		uint8_t scrollOffset = 30;
+
+		void bind(const String& path);
+
+		// Right edge is kept free for the track length and the analyzed tempo
+		static const uint8_t bpmWidth = 22;
+		static const uint8_t durationWidth = 30;
+		int32_t nameWidth() const;
+		void drawBPM();
+		void drawDuration();
 	};
 }
 #endif //JAYD_FIRMWARE_LISTITEM_H
@@ -1,45 +1,71 @@
 #include <SD.h>
 #include "SongList.h"
 #include "../MainMenu/MainMenu.h"
+#include "../TextInputScreen/TextInputScreen.h"
 #include <JayD.h>
 #include <Loop/LoopManager.h>
 #include <SPIFFS.h>
 #include <FS/CompressedFile.h>
 #include "../../Fonts.h"
+#include "../../Library/TrackPreloader.h"
+#include "../../Library/BeatAnalyzer.h"
+#include "../../Library/SongIndex.h"
+#include "../../Library/SongScanner.h"
+#include "../../Library/CardCache.h"
+#include <esp_heap_caps.h>
 #include <algorithm>
 
 SongList::SongList* SongList::SongList::instance = nullptr;
-const char* SongList::SongList::indexFileName = "/.jayd_song_index";
+const char* SongList::SongList::scanItemName = "⚙ Scan SD Card";
 
-SongList::SongList::SongList(Display& display) : Context(display){
+SongList::SongList::SongList(Display& display) : Context(display), background(screen), scheduler("SongList", Fps){
 	instance = this;
 
 	scrollLayout = new ScrollLayout(&getScreen());
 	list = new LinearLayout(scrollLayout, VERTICAL);
 
+	for(auto& row : rows){
+		row = new ListItem(list, "");
+	}
+
 	buildUI();
 	SongList::pack();
 }
 
 SongList::SongList::~SongList(){
 	instance = nullptr;
+
+	// Rows not bound right now aren't children of the list, take all of them out and delete them here
+	list->getChildren().clear();
+	for(auto row : rows){
+		delete row;
+	}
+
 	free(backgroundBuffer);
 }
 
-void SongList::SongList::checkSD(){
-	for(auto song : songs){
-		delete song;
-	}
-	list->getChildren().clear();
-	songs.clear();
+void SongList::SongList::clearList(){
+	table.clear();
 	selectedElement = 0;
+	firstRow = 0;
 	empty = true;
+	jumpMode = false;
+	bindRows();
+}
+
+void SongList::SongList::checkSD(){
+	Scanner.cancel();
+	scanning = false;
+	rebuildAfterScan = false;
+	listed = false;
+	clearList();
 
 	if(!insertedSD){
 		insertedSD = SD.begin(22, SPI);
 	}
 
 	if(!insertedSD){
+		bindRows();
 		draw();
 		screen.commit();
 		return;
@@ -52,165 +78,284 @@ void SongList::SongList::checkSD(){
 	insertedSD = root;
 	if(!insertedSD){
 		root.close();
+		bindRows();
 		draw();
 		screen.commit();
 		return;
 	}
 
-	if(loadSongIndex()){
-		Serial.printf("Loaded %d songs from index\n", songs.size());
-		// Sort loaded songs alphabetically
-		if(!songs.empty()){
-			std::sort(songs.begin(), songs.end(), [](ListItem* a, ListItem* b) {
-				String pathA = a->getPath();
-				String pathB = b->getPath();
-				// Extract filename for comparison
-				String fileA = pathA.substring(pathA.lastIndexOf('/') + 1);
-				String fileB = pathB.substring(pathB.lastIndexOf('/') + 1);
-				fileA.toLowerCase();
-				fileB.toLowerCase();
-				return fileA < fileB;
-			});
-			
-			// Rebuild UI with sorted order
-			list->getChildren().clear();
-			for(auto song : songs){
-				list->addChild(song);
-			}
-		}
+	root.close();
+
+	// The stored index shows the library right away, from flash for a card seen before or from the card
+	// itself. The background scan then only lists directories that changed. Without an index the list
+	// fills up from the scan's batches as songs are found.
+	Cards.identify();
+	bool indexed = Cards.load(Songs) || Songs.load();
+	if(indexed){
+		buildList("");
 	}else{
 		Serial.println("Index not found or outdated, scanning SD card...");
-		scanning = true;
-		scanProgress = 0;
-		totalFiles = 0;
-		draw();
-		screen.commit();
-		searchDirectories(root);
-		scanning = false;
-		Serial.printf("Scan complete: found %d songs\n", songs.size());
-		
-		// Sort songs alphabetically
-		if(!songs.empty()){
-			Serial.println("Sorting songs alphabetically...");
-			std::sort(songs.begin(), songs.end(), [](ListItem* a, ListItem* b) {
-				String pathA = a->getPath();
-				String pathB = b->getPath();
-				// Extract filename for comparison
-				String fileA = pathA.substring(pathA.lastIndexOf('/') + 1);
-				String fileB = pathB.substring(pathB.lastIndexOf('/') + 1);
-				fileA.toLowerCase();
-				fileB.toLowerCase();
-				return fileA < fileB;
-			});
-			
-			// Rebuild UI with sorted order
-			list->getChildren().clear();
-			for(auto song : songs){
-				list->addChild(song);
-			}
-			Serial.println("Songs sorted alphabetically");
+	}
+
+	scanning = true;
+	scannerGeneration = Scanner.getGeneration();
+	Scanner.start(!indexed);
+	listed = true;
+
+	draw();
+	screen.commit();
+}
+
+void SongList::SongList::buildList(const String& selectedPath){
+	clearList();
+
+	// A crate lists its songs in its own order, looked up by ID without touching the card
+	for(uint32_t i = 0; crate.isOpen() && i < crate.size(); i++){
+		int32_t song = Songs.findId(crate.getId(i));
+		if(song < 0) continue;
+
+		table.add(Songs.getPath(song), Songs.getInfo(song).duration);
+	}
+
+	PSRAMVector<uint8_t> matches;
+	bool filtered = filter.length() != 0;
+	bool library = !crate.isOpen();
+	if(library && filtered){
+		uint32_t searchTime = micros();
+		uint32_t found = Songs.search(filter.c_str(), matches);
+		Serial.printf("SongList: \"%s\" found %u songs in %u us\n", filter.c_str(), found, micros() - searchTime);
+	}
+
+	// The index keeps every ordering presorted, the list just copies one out. A search filters it
+	// and keeps a section for every one that still has songs.
+	uint32_t sectionCount = Songs.getSectionCount(order);
+	uint32_t section = 0;
+	int32_t lastSection = -1;
+	for(uint32_t i = 0; library && i < Songs.getCount(); i++){
+		uint32_t song = Songs.getSong(order, i);
+		if(filtered && !matches[song]) continue;
+
+		while(section + 1 < sectionCount && Songs.getSection(order, section + 1).position <= i){
+			section++;
 		}
-		
-		draw();
-		screen.commit();
-		if(!songs.empty()){
-			createSongIndex();
+		if(section < sectionCount && (int32_t) section != lastSection){
+			table.addSection(table.size(), Songs.getSection(order, section).letter);
+			lastSection = section;
 		}
+
+		table.add(Songs.getPath(song), Songs.getInfo(song).duration);
 	}
-	root.close();
-	empty = songs.empty();
 
-	// Always add the manual scan option at the bottom
-	songs.push_back(new ListItem(list, "⚙ Scan SD Card"));
-	list->addChild(songs.back());
+	empty = table.size() == 0;
+
+	// Tracks that already have a tempo are skipped by the analyzer, so this resumes an interrupted pass
+	Beats.begin();
+	Beats.queueLibrary(order);
+
+#ifdef DEBUG
+	Serial.printf("SongList: %u songs, %u bytes of PSRAM table, %u bytes of internal heap free\n", table.size(),
+				  table.getMemoryUsage(), heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+#endif
 
 	if(!empty){
-		list->reflow();
-		list->repos();
-		scrollLayout->scrollIntoView(0, 5);
-		songs.front()->setSelected(true);
+		selectedElement = max(table.find(selectedPath.c_str()), (int32_t) 0);
+		selectionChanged();
 	}
 
-	draw();
-	screen.commit();
+	bindRows();
 }
 
-void SongList::SongList::searchDirectories(File dir){
-	if(!dir) return;
+void SongList::SongList::addSongs(const SongScanner::Batch& batch){
+	// A search or a crate is applied once the scan has built the index
+	if(filter.length() != 0 || crate.isOpen()) return;
 
-	File f;
-	while(f = dir.openNextFile()){
-		String name = f.name();
-		String fileName = name.substring(name.lastIndexOf('/') + 1);
-		
-		// Skip hidden files and directories (starting with . or ._)
-		if(fileName.startsWith(".") || fileName.startsWith("._")){
-			f.close();
-			continue;
+	// New songs go in front of the scan option, which stays the last entry
+	bool scanItemSelected = !empty && selectedElement == table.size();
+
+	for(uint8_t i = 0; i < batch.count; i++){
+		table.add(batch.paths[i]);
+	}
+
+	if(empty && table.size() != 0){
+		empty = false;
+		selectedElement = 0;
+		selectionChanged();
+	}else if(scanItemSelected){
+		selectedElement = table.size();
+	}
+
+	bindRows();
+}
+
+void SongList::SongList::bindRows(){
+	// One entry past the songs is the scan option
+	int count = insertedSD ? table.size() + 1 : 0;
+
+	if(selectedElement < firstRow){
+		firstRow = selectedElement;
+	}else if(selectedElement >= firstRow + RowCount){
+		firstRow = selectedElement - RowCount + 1;
+	}
+	firstRow = max(0, min(firstRow, count - RowCount));
+
+	list->getChildren().clear();
+
+	for(int i = 0; i < RowCount && firstRow + i < count; i++){
+		int entry = firstRow + i;
+		ListItem* row = rows[i];
+
+		bool rebound = row->setPath(entry < table.size() ? table.getPath(entry) : scanItemName);
+		rebound |= row->setDuration(entry < table.size() ? table.getDuration(entry) : 0);
+		bool selected = !empty && entry == selectedElement;
+		if(rebound || row->isSelected() != selected){
+			row->setSelected(selected);
 		}
-		
-		if(f.isDirectory()){
-			Serial.printf("Scanning directory: %s\n", name.c_str());
-			searchDirectories(f);
-			f.close();
-			continue;
+
+		list->addChild(row);
+	}
+
+	list->reflow();
+	list->repos();
+}
+
+String SongList::SongList::getSelectedPath() const{
+	if(selectedElement < table.size()){
+		return table.getPath(selectedElement);
+	}
+
+	return scanItemName;
+}
+
+void SongList::SongList::selectionChanged(){
+	Preloader.cancel();
+	selectionTime = millis();
+	preloadRequested = false;
+}
+
+void SongList::SongList::loop(uint t){
+	if(moved){
+		moved = false;
+		bindRows();
+		scheduler.invalidate();
+	}
+
+	if(scanning){
+		SongScanner::Batch batch;
+		while(Scanner.receive(batch)){
+			addSongs(batch);
+			SongScanner::release(batch);
+			scheduler.invalidate();
+		}
+
+		if(!Scanner.isRunning()){
+			scanning = false;
+
+			// Directories that changed since the stored index brought new or removed songs
+			if(Scanner.getGeneration() != scannerGeneration || rebuildAfterScan){
+				scannerGeneration = Scanner.getGeneration();
+				rebuildAfterScan = false;
+				buildList(empty ? String() : getSelectedPath());
+			}
+
+			scheduler.invalidate();
 		}
+	}
 
-		// Only process .aac files
-		String lowerName = fileName;
-		lowerName.toLowerCase();
-		if(!lowerName.endsWith(".aac")){
-			f.close();
-			continue;
+	if(insertedSD && !empty){
+		if(Beats.getGeneration() != beatGeneration){
+			beatGeneration = Beats.getGeneration();
+			scheduler.invalidate();
 		}
 
-		totalFiles++;
-		if(totalFiles % 10 == 0 && scanning){
-			draw();
-			screen.commit();
+		if(!preloadRequested && millis() - selectionTime >= preloadDwell){
+			preloadRequested = true;
+
+			// Last entry is the scan option, not a file
+			if(selectedElement < table.size()){
+				Preloader.request(table.getPath(selectedElement));
+			}
 		}
 
-		Serial.printf("Found AAC file: %s\n", name.c_str());
-		songs.push_back(new ListItem(list, name));
-		list->addChild(songs.back());
-		scanProgress++;
+		if(rows[selectedElement - firstRow]->checkScrollUpdate()){
+			scheduler.invalidate();
+		}
+	}
 
-		f.close();
+	if(noticeTime != 0 && millis() - noticeTime >= noticeDuration){
+		noticeTime = 0;
+		scheduler.invalidate();
 	}
-}
 
-void SongList::SongList::loop(uint t){
-	if(!insertedSD || empty) return;
-	if(songs[selectedElement]->checkScrollUpdate()) {
+	scheduler.run([this](){
 		draw();
 		screen.commit();
+	});
+}
+
+void SongList::SongList::move(int8_t value){
+	if(jumpMode){
+		jump(value);
+	}else{
+		selectedElement += accelerate(value);
+
+		// Single steps wrap around at both ends, accelerated ones stop there. The scan option is the last entry.
+		int count = table.size() + 1;
+		if(step > 1){
+			selectedElement = max(0, min(selectedElement, count - 1));
+		}else if(selectedElement < 0){
+			selectedElement = count - 1;
+		}else if(selectedElement >= count){
+			selectedElement = 0;
+		}
 	}
+
+	selectionChanged();
+	moved = true;
 }
 
-void SongList::SongList::start(){
+int SongList::SongList::accelerate(int8_t value){
+	uint32_t now = millis();
 
-	InputJayD::getInstance()->setEncoderMovedCallback(ENC_MID, [](int8_t value){
-		if(instance == nullptr) return;
+	if(now - lastDetent <= accelerationInterval && (value > 0) == (lastDirection > 0)){
+		step = min(step * 2, max(1, (int) table.size() / maxStepFraction));
+	}else{
+		step = 1;
+	}
 
-		if(instance->empty || !instance->insertedSD) return;
+	lastDetent = now;
+	lastDirection = value;
+	return value * step;
+}
 
-		instance->songs[instance->selectedElement]->setSelected(false);
-		instance->selectedElement += value;
-		
-		// Circular navigation - wrap around at both ends
-		if(instance->selectedElement < 0){
-			instance->selectedElement = instance->songs.size() - 1;
-		}else if(instance->selectedElement >= instance->songs.size()){
-			instance->selectedElement = 0;
+void SongList::SongList::jump(int8_t value){
+	int count = table.getSectionCount();
+	if(count == 0) return;
+
+	int section;
+	if(selectedElement >= table.size()){
+		// From the scan option forward is the first section, back is the last one
+		section = value > 0 ? -1 : count;
+	}else{
+		section = table.getSection(selectedElement);
+
+		// Turning back from inside a section goes to its start first
+		if(value < 0 && section >= 0 && selectedElement > table.getSectionStart(section)){
+			value++;
 		}
+	}
 
-		instance->songs[instance->selectedElement]->setSelected(true);
+	section = ((section + value) % count + count) % count;
+	selectedElement = table.getSectionStart(section);
+}
 
-		instance->scrollLayout->scrollIntoView(instance->selectedElement, 6);
-		instance->draw();
-		instance->screen.commit();
+void SongList::SongList::start(){
 
+	InputJayD::getInstance()->setEncoderMovedCallback(ENC_MID, [](int8_t value){
+		if(instance == nullptr) return;
 
+		if(instance->empty || !instance->insertedSD) return;
+
+		instance->move(value);
 	});
 
 	InputJayD::getInstance()->setBtnPressCallback(BTN_MID, [](){
@@ -221,12 +366,19 @@ void SongList::SongList::start(){
 			return;
 		}
 
-		if(instance->songs.size() <= instance->selectedElement) return;
+		if(instance->selectedElement > instance->table.size()) return;
+
+		// In jump mode the press just settles on the section start
+		if(instance->jumpMode){
+			instance->jumpMode = false;
+			instance->scheduler.invalidate();
+			return;
+		}
 
-		String path = instance->songs[instance->selectedElement]->getPath();
+		String path = instance->getSelectedPath();
 		
 		// Check if scan option was selected
-		if(path == "⚙ Scan SD Card"){
+		if(path == scanItemName){
 			Serial.println("=== MANUAL SD SCAN TRIGGERED ===");
 			instance->forceScanSD();
 			instance->checkSD(); // Refresh the list
@@ -245,19 +397,41 @@ void SongList::SongList::start(){
 		}
 		file.close();
 
+		if(instance->queue != nullptr){
+			if(instance->crate.isOpen() && instance->queue->open(instance->crate.getName())){
+				instance->queue->setPosition(instance->queue->find(path.c_str()));
+			}else{
+				instance->queue->close();
+			}
+		}
+
 		Serial.printf("\n=== SONGLIST SELECTION ===\n");
 		Serial.printf("Selected file: %s\n", path.c_str());
 		Serial.printf("Free heap before pop: %u bytes\n", ESP.getFreeHeap());
 		Serial.println("Calling pop() to return to MixScreen...");
 		
+		instance->picked = path;
 		instance->pop(new String(path));
 		
 		Serial.println("=== SONGLIST SELECTION END ===\n");
 	});
 
 	Input.addListener(this);
+	picked = "";
+	Preloader.begin();
 	waiting = false;
-	checkSD();
+
+	// Coming back from the search the index is still loaded, the new filter is applied to it. The card
+	// is only read and scanned again on the first start or when another one went in meanwhile.
+	// A scan that outlived the child screen is still using the card and Cards, so the card isn't
+	// identified again until it's done.
+	uint32_t card = Cards.getKey();
+	bool sameCard = Scanner.isRunning() || (Cards.identify() && Cards.getKey() == card);
+	if(listed && insertedSD && sameCard){
+		rebuildList();
+	}else{
+		checkSD();
+	}
 
 	LoopManager::addListener(this);
 
@@ -265,11 +439,29 @@ void SongList::SongList::start(){
 	screen.commit();
 }
 
+void SongList::SongList::rebuildList(){
+	// Songs can't be read while a scan that outlived the child screen still runs, the list keeps its
+	// rows until then and is rebuilt when it's done
+	if(Scanner.isRunning()){
+		scanning = true;
+		rebuildAfterScan = true;
+		return;
+	}
+
+	buildList("");
+}
+
 void SongList::SongList::stop(){
 	InputJayD::getInstance()->removeEncoderMovedCallback(ENC_MID);
 	InputJayD::getInstance()->removeBtnPressCallback(BTN_MID);
 	Input.removeListener(this);
 	LoopManager::removeListener(this);
+
+	// A running scan finishes on its own and stores the index, there's just nobody to show it to
+	Scanner.stopStream();
+	scanning = false;
+
+	Preloader.end(picked);
 }
 
 void SongList::SongList::draw(){
@@ -279,16 +471,41 @@ void SongList::SongList::draw(){
 	canvas->setFont(&u8g2_font_DigitalDisco_tf);
 	canvas->setTextColor(TFT_WHITE);
 
-	canvas->drawIcon(backgroundBuffer, 0, 0, 160, 128, 1);
+	if(!background.restore()){
+		canvas->drawIcon(backgroundBuffer, 0, 0, 160, 128, 1);
+
+		// The decoded picture is only needed until it's cached
+		if(background.capture()){
+			free(backgroundBuffer);
+			backgroundBuffer = nullptr;
+		}
+	}
 
 	screen.draw();
 
-	canvas->drawIcon(backgroundBuffer, 0, 0, 160, 19, 1);
+	// Rows scrolled up under the header are covered again by its band of the background
+	if(!background.restore(0, 19)){
+		canvas->drawIcon(backgroundBuffer, 0, 0, 160, 19, 1);
+	}
 
 	canvas->setTextDatum(BC_DATUM);
-	String headerText = "SD card";
-	if(!empty && insertedSD){
-		headerText += " - " + String(songs.size()) + " songs";
+	String headerText = order == BY_NAME ? "SD card" : SongIndex::getOrderName(order);
+	if(crate.isOpen()){
+		headerText = crate.getName();
+	}else if(filter.length() != 0){
+		headerText = "\"" + filter + "\"";
+	}
+	int32_t section = jumpMode && selectedElement < table.size() ? table.getSection(selectedElement) : -1;
+	if(section >= 0){
+		headerText = String("Jump to ") + table.getSectionLetter(section);
+	}else if(!empty && insertedSD){
+		headerText += " - " + String(table.size()) + " songs";
+		if(scanning){
+			headerText += "...";
+		}
+	}
+	if(noticeTime != 0){
+		headerText = notice;
 	}
 	canvas->drawString(headerText, screen.getWidth()/2, 15);
 
@@ -298,12 +515,12 @@ void SongList::SongList::draw(){
 		return;
 	}
 	
-	if(scanning){
+	if(scanning && empty){
 		canvas->drawString("Scanning SD...", screen.getWidth()/2, 50);
-		String progress = String(scanProgress) + " songs found";
+		String progress = String(Scanner.getFound()) + " songs found";
 		canvas->drawString(progress, screen.getWidth()/2, 70);
-		String fileCount = String(totalFiles) + " files checked";
-		canvas->drawString(fileCount, screen.getWidth()/2, 90);
+		String folderCount = String(Songs.getDirectoryCount()) + " folders checked";
+		canvas->drawString(folderCount, screen.getWidth()/2, 90);
 		canvas->setTextDatum(TL_DATUM);
 		return;
 	}
@@ -311,8 +528,15 @@ void SongList::SongList::draw(){
 	if(!insertedSD){
 		canvas->drawString("Not inserted!", screen.getWidth()/2, 65);
 		canvas->setTextDatum(TL_DATUM);
+	}else if(empty && crate.isOpen()){
+		canvas->drawString("Crate is empty!", screen.getWidth()/2, 55);
+		canvas->setTextDatum(TL_DATUM);
+	}else if(empty && filter.length() != 0){
+		canvas->drawString("No matches!", screen.getWidth()/2, 55);
+		canvas->drawString("Search again to clear", screen.getWidth()/2, 75);
+		canvas->setTextDatum(TL_DATUM);
 	}else if(empty){
-		String debugMsg = String(totalFiles) + " files scanned";
+		String debugMsg = String(Songs.getDirectoryCount()) + " folders scanned";
 		canvas->drawString("No AAC files!", screen.getWidth()/2, 55);
 		canvas->drawString(debugMsg, screen.getWidth()/2, 75);
 		canvas->setTextDatum(TL_DATUM);
@@ -340,6 +564,7 @@ void SongList::SongList::pack(){
 	Context::pack();
 	free(backgroundBuffer);
 	backgroundBuffer = nullptr;
+	background.release();
 }
 
 void SongList::SongList::unpack(){
@@ -357,67 +582,108 @@ void SongList::SongList::unpack(){
 	bgFile.close();
 }
 
-bool SongList::SongList::indexExists(){
-	File indexFile = SD.open(indexFileName);
-	bool exists = indexFile && !indexFile.isDirectory();
-	if(indexFile) indexFile.close();
-	return exists;
-}
+void SongList::SongList::btnEnc(uint8_t i){
+	if(scanning) return;
 
-bool SongList::SongList::indexNeedsUpdate(){
-	if(!indexExists()) return true;
-	
-	File indexFile = SD.open(indexFileName);
-	if(!indexFile) return true;
-	
-	time_t indexTime = indexFile.getLastWrite();
-	indexFile.close();
-	
-	File root = SD.open("/");
-	if(!root) return true;
-	
-	time_t rootTime = root.getLastWrite();
-	root.close();
-	
-	return rootTime > indexTime;
-}
+	// Third encoder button searches, also from an empty result so the search can be cleared
+	if(i == 2 && insertedSD && (!empty || filter.length() != 0)){
+		openSearch();
+		return;
+	}
 
-bool SongList::SongList::loadSongIndex(){
-	if(indexNeedsUpdate()){
-		return false;
+	// Fourth one steps through the crates and back to the library
+	if(i == 3 && insertedSD){
+		openNextCrate();
+		return;
 	}
-	
-	File indexFile = SD.open(indexFileName, FILE_READ);
-	if(!indexFile){
-		return false;
+
+	if(empty) return;
+
+	if(i == 0){
+		// Top left encoder button steps through the orderings
+		order = (SongOrder) ((order + 1) % ORDER_COUNT);
+		buildList(getSelectedPath());
+		scheduler.invalidate();
+	}else if(i == 1 && table.getSectionCount() > 1){
+		// The one next to it toggles letter jumps on the main encoder
+		jumpMode = !jumpMode;
+		scheduler.invalidate();
+	}else if(i == 4){
+		addToCrate();
 	}
-	
-	String line;
-	while(indexFile.available()){
-		line = indexFile.readStringUntil('\n');
-		line.trim();
-		if(line.length() > 0){
-			songs.push_back(new ListItem(list, line));
-			list->addChild(songs.back());
-		}
+}
+
+void SongList::SongList::openNextCrate(){
+	std::vector<String> names;
+	Crate::list(names);
+
+	// Library comes after the last crate
+	auto current = std::find(names.begin(), names.end(), crate.getName());
+	auto next = crate.isOpen() && current != names.end() ? current + 1 : names.begin();
+
+	crate.close();
+	if(next != names.end() && crate.open(*next)){
+		targetCrate = crate.getName();
+		filter = "";
 	}
-	indexFile.close();
-	
-	return !songs.empty();
+
+	Serial.printf("SongList: showing %s\n", crate.isOpen() ? crate.getName().c_str() : "the library");
+	buildList("");
+	scheduler.invalidate();
 }
 
-void SongList::SongList::createSongIndex(){
-	File indexFile = SD.open(indexFileName, FILE_WRITE);
-	if(!indexFile){
-		Serial.println("Failed to create song index file");
+void SongList::SongList::addToCrate(){
+	// Last entry is the scan option
+	if(selectedElement >= table.size()) return;
+
+	String path = getSelectedPath();
+	if(!Crate::add(targetCrate, path.c_str())){
+		showNotice("Crate write failed");
 		return;
 	}
-	
-	for(auto song : songs){
-		indexFile.println(song->getPath());
+
+	// The open crate shows the song at its end right away
+	if(crate.isOpen() && crate.getName() == targetCrate){
+		crate.open(targetCrate);
+		buildList(path);
 	}
-	indexFile.close();
-	Serial.printf("Created song index with %d songs\n", songs.size());
+
+	showNotice("Added to " + targetCrate);
+}
+
+void SongList::SongList::showNotice(const String& text){
+	notice = text;
+	noticeTime = millis();
+	scheduler.invalidate();
+}
+
+void SongList::SongList::setQueue(Crate* queue){
+	this->queue = queue;
+}
+
+void SongList::SongList::openSearch(){
+	auto search = new TextInputScreen::TextInputScreen(*screen.getDisplay());
+
+	// The scanner swaps the index tables when it's done, the count is only shown while it's idle
+	search->setHint([](const String& text) -> String {
+		if(text.length() == 0 || Scanner.isRunning()) return "";
+
+		PSRAMVector<uint8_t> matches;
+		return String(Songs.search(text.c_str(), matches)) + " songs";
+	});
+
+	search->push(this);
+}
+
+void SongList::SongList::returned(void* data){
+	// Confirming an empty search shows the whole library again
+	String* text = static_cast<String*>(data);
+	crate.close();
+	filter = *text;
+	filter.trim();
+	delete text;
+
+	Serial.printf("SongList: search \"%s\"\n", filter.c_str());
 }
 
 void SongList::SongList::encTwoTop(){
@@ -439,13 +705,11 @@ void SongList::SongList::forceScanSD(){
 		return;
 	}
 	
-	// Delete existing index to force rescan
-	if(SD.exists(indexFileName)){
-		SD.remove(indexFileName);
-		Serial.println("Removed existing song index to force rescan");
-	} else {
-		Serial.println("No existing index found to remove");
-	}
-	
+	// Without a stored index every directory gets listed again
+	Scanner.cancel();
+	Songs.remove();
+	Cards.identify();
+	Cards.remove();
+
 	Serial.println("SD card will be rescanned on next SongList access");
 }
@@ -7,8 +7,14 @@
 #include <UI/LinearLayout.h>
 #include <UI/ScrollLayout.h>
 #include "ListItem.h"
+#include "SongTable.h"
 #include <Input/InputJayD.h>
 #include "../../InputKeys.h"
+#include "../../Library/SongScanner.h"
+#include "../../Library/SongIndex.h"
+#include "../../Library/Crate.h"
+#include "../../Render/BackgroundLayer.h"
+#include "../../Render/FrameScheduler.h"
 
 namespace SongList {
 	class SongList : public Context, public LoopListener, public InputListener {
@@ -26,6 +32,12 @@ namespace SongList {
 
 		void loop(uint t) override;
 
+		void returned(void* data) override;
+
+		// Picking a song from an open crate sets queue up to play the rest of the crate after it,
+		// picking one from the library closes it
+		void setQueue(Crate* queue);
+
 		void pack() override;
 
 		void unpack() override;
@@ -38,33 +50,90 @@ namespace SongList {
 		int selectedElement = 0;
 
 		Color *backgroundBuffer = nullptr;
+		BackgroundLayer background;
 
-		std::vector<ListItem *> songs;
+		// Only the visible rows exist as elements, they get bound to table entries as the selection moves
+		static const int RowCount = 4;
+		ListItem* rows[RowCount];
+		int firstRow = 0;
+		SongTable table;
 
 		void buildUI();
 
 		void checkSD();
-
-		void searchDirectories(File dir);
-		
-		bool loadSongIndex();
-		void createSongIndex();
-		bool indexExists();
-		bool indexNeedsUpdate();
+		void rebuildList();
+		void clearList();
+		void buildList(const String& selectedPath);
+		void addSongs(const SongScanner::Batch& batch);
+		void bindRows();
+		String getSelectedPath() const;
+
+		// Encoder turns only move the selection, loop() binds the rows and the scheduler draws
+		// at most once per frame, so a burst of detents costs a single redraw
+		bool moved = false;
+		FrameScheduler scheduler;
+		static const uint8_t Fps = 30;
+		void move(int8_t value);
+
+		// Detents in quick succession in one direction double the step, up to a fraction of the list
+		uint32_t lastDetent = 0;
+		int8_t lastDirection = 0;
+		int step = 1;
+		int accelerate(int8_t value);
+
+		// Letter jump mode moves the selection between the sections of the current ordering
+		bool jumpMode = false;
+		void jump(int8_t value);
+
+		// Search text from TextInputScreen, the list then only shows the songs the index finds for it
+		String filter;
+		void openSearch();
+
+		// Open crate replaces the library in the list, songs are added to the last opened one
+		Crate crate;
+		Crate* queue = nullptr;
+		String targetCrate = "Favorites";
+		void openNextCrate();
+		void addToCrate();
+
+		// Short message in the header, e.g. after adding to a crate
+		String notice;
+		uint32_t noticeTime = 0;
+		void showNotice(const String& text);
 
 		void encTwoTop() override;
+		void btnEnc(uint8_t i) override;
+
+		SongOrder order = BY_NAME;
 		bool waiting = false;
 		bool insertedSD = true;
 		bool empty = true;
+		// Background scan of the card is running and feeding this list
 		bool scanning = false;
-		int scanProgress = 0;
-		int totalFiles = 0;
+		uint32_t scannerGeneration = 0;
+		// Songs is loaded for the inserted card, a returning child screen doesn't need to reload it
+		bool listed = false;
+		// The list waits for a running scan before it can read Songs again
+		bool rebuildAfterScan = false;
 
 		uint32_t prevSDCheck = 0;
-		uint32_t lastIndexCheck = 0;
+
+		// Highlighted track gets preloaded once the selection rests on it
+		uint32_t selectionTime = 0;
+		bool preloadRequested = true;
+		void selectionChanged();
+
+		uint32_t beatGeneration = 0;
 
 		static const uint16_t checkInterval = 500;
-		static const char* indexFileName;
+		static const uint16_t preloadDwell = 300;
+
+		// Track handed to the deck, its preloaded head survives the cache release in stop()
+		String picked;
+		static const uint8_t accelerationInterval = 60;
+		static const uint8_t maxStepFraction = 50;
+		static const uint16_t noticeDuration = 1500;
+		static const char* scanItemName;
 
 	public:
 		static void forceScanSD();
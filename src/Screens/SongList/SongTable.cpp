@@ -0,0 +1,93 @@
+#include "SongTable.h"
+#include <esp_heap_caps.h>
+#include <algorithm>
+
+void SongList::SongTable::clear(){
+	paths.clear();
+	entries.clear();
+	durations.clear();
+	sections.clear();
+}
+
+bool SongList::SongTable::add(const char* path, uint16_t duration){
+	int32_t offset = paths.append(path, strlen(path) + 1);
+	if(offset < 0) return false;
+
+	if(!durations.push_back(duration)) return false;
+	if(!entries.push_back(offset)){
+		durations.resize(entries.size());
+		return false;
+	}
+
+	return true;
+}
+
+uint32_t SongList::SongTable::size() const{
+	return entries.size();
+}
+
+const char* SongList::SongTable::getPath(uint32_t entry) const{
+	return &paths[entries[entry]];
+}
+
+uint16_t SongList::SongTable::getDuration(uint32_t entry) const{
+	return durations[entry];
+}
+
+int32_t SongList::SongTable::find(const char* path) const{
+	for(uint32_t i = 0; i < entries.size(); i++){
+		if(strcmp(getPath(i), path) == 0) return i;
+	}
+
+	return -1;
+}
+
+bool SongList::SongTable::addSection(uint32_t entry, char letter){
+	return sections.push_back({ entry, letter });
+}
+
+uint32_t SongList::SongTable::getSectionCount() const{
+	return sections.size();
+}
+
+uint32_t SongList::SongTable::getSectionStart(uint32_t section) const{
+	return sections[section].entry;
+}
+
+char SongList::SongTable::getSectionLetter(uint32_t section) const{
+	return sections[section].letter;
+}
+
+int32_t SongList::SongTable::getSection(uint32_t entry) const{
+	// Last section starting at or before entry
+	auto next = std::upper_bound(sections.begin(), sections.end(), entry, [](uint32_t entry, const Section& section){
+		return entry < section.entry;
+	});
+
+	return (next - sections.begin()) - 1;
+}
+
+size_t SongList::SongTable::getMemoryUsage() const{
+	return paths.size() + entries.size() * (sizeof(uint32_t) + sizeof(uint16_t)) + sections.size() * sizeof(Section);
+}
+
+#ifdef DEBUG
+void SongList::SongTable::benchmark(){
+	const uint32_t sizes[] = { 10, 100, 1000, 10000 };
+	char path[96];
+
+	for(uint32_t count : sizes){
+		uint32_t internalBefore = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+		uint32_t psramBefore = ESP.getFreePsram();
+
+		SongTable table;
+		for(uint32_t i = 0; i < count; i++){
+			snprintf(path, sizeof(path), "/Artist %03u/Album %u/Track %05u - Synthetic Artist.aac", i / 500, (i / 50) % 10, i);
+			table.add(path, 180 + i % 120);
+		}
+
+		Serial.printf("SongTable: %5u songs - internal heap %d bytes, PSRAM %d bytes\n", count,
+					  (int) (internalBefore - heap_caps_get_free_size(MALLOC_CAP_INTERNAL)), (int) (psramBefore - ESP.getFreePsram()));
+	}
+}
+#endif
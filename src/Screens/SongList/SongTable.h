@@ -0,0 +1,53 @@
+#ifndef JAYD_FIRMWARE_SONGTABLE_H
+#define JAYD_FIRMWARE_SONGTABLE_H
+
+#include <Arduino.h>
+#include "../../Util/PSRAMVector.h"
+
+namespace SongList {
+	// Entries of the song list: every path once in a PSRAM pool plus an offset and duration per entry.
+	// The list only keeps a handful of row elements and binds them to entries as it scrolls,
+	// so the internal heap doesn't grow with the size of the library.
+	class SongTable {
+	public:
+		void clear();
+		// Duration in seconds for the row, 0 while the track isn't probed yet
+		bool add(const char* path, uint16_t duration = 0);
+
+		uint32_t size() const;
+		const char* getPath(uint32_t entry) const;
+		uint16_t getDuration(uint32_t entry) const;
+
+		// Index of the entry with path, -1 if there is none
+		int32_t find(const char* path) const;
+
+		// Jump points copied from the index ordering the table was filled from, added in entry order
+		bool addSection(uint32_t entry, char letter);
+		uint32_t getSectionCount() const;
+		uint32_t getSectionStart(uint32_t section) const;
+		char getSectionLetter(uint32_t section) const;
+
+		// Section the entry belongs to, -1 before the first one
+		int32_t getSection(uint32_t entry) const;
+
+		size_t getMemoryUsage() const;
+
+#ifdef DEBUG
+		// Prints internal heap and PSRAM used by tables of 10 up to 10k songs, run with "bench table" on serial
+		static void benchmark();
+#endif
+
+	private:
+		PSRAMVector<char> paths;
+		PSRAMVector<uint32_t> entries;
+		PSRAMVector<uint16_t> durations;
+
+		struct Section {
+			uint32_t entry;
+			char letter;
+		};
+		PSRAMVector<Section> sections;
+	};
+}
+
+#endif //JAYD_FIRMWARE_SONGTABLE_H
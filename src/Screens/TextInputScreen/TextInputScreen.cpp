@@ -17,7 +17,17 @@ TextInputScreen::TextInputScreen::~TextInputScreen(){
 	instance = nullptr;
 }
 
+void TextInputScreen::TextInputScreen::setHint(std::function<String(const String& text)> hint){
+	this->hint = hint;
+}
+
+void TextInputScreen::TextInputScreen::updateHint(){
+	if(!hint) return;
+	hintText = hint(text);
+}
+
 void TextInputScreen::TextInputScreen::start(){
+	updateHint();
 	instance->draw();
 	instance->screen.commit();
 	InputJayD::getInstance()->setEncoderMovedCallback(0, [](int8_t value){
@@ -48,6 +58,7 @@ void TextInputScreen::TextInputScreen::start(){
 			instance->text += (instance->capitalLetters || instance->shiftLetters ? (char) ('A' + instance->selectedIndex) : (char) ('a' + instance->selectedIndex));
 			instance->shiftLetters = false;
 		}
+		instance->updateHint();
 		instance->draw();
 		instance->screen.commit();
 
@@ -69,6 +80,13 @@ void TextInputScreen::TextInputScreen::draw(){
 	sprite->setCursor(5, 25);
 	sprite->printf("%s", text.c_str());
 
+	if(hintText.length() != 0){
+		sprite->setTextColor(TFT_LIGHTGREY);
+		sprite->setCursor(155 - sprite->textWidth(hintText), 8);
+		sprite->printf("%s", hintText.c_str());
+		sprite->setTextColor(TFT_WHITE);
+	}
+
 	uint8_t static const rows = 4;
 	uint8_t static const columns = 8;
 	for(int i = 0; i < rows; i++){
@@ -4,6 +4,7 @@
 
 #include <Support/Context.h>
 #include <FS.h>
+#include <functional>
 
 namespace TextInputScreen {
 	class TextInputScreen : public Context {
@@ -23,6 +24,10 @@ namespace TextInputScreen {
 
 		void unpack() override;
 
+		// Called with the text after every keystroke, the returned line is shown above the input
+		// (e.g. how many songs a search finds)
+		void setHint(std::function<String(const String& text)> hint);
+
 	private:
 
 		static TextInputScreen *instance;
@@ -37,6 +42,10 @@ namespace TextInputScreen {
 		int selectedIndex = 0;
 
 		Color* backgroundBuffer= nullptr;
+
+		std::function<String(const String& text)> hint;
+		String hintText;
+		void updateHint();
 	};
 }
 
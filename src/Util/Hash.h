@@ -0,0 +1,25 @@
+#ifndef JAYD_FIRMWARE_HASH_H
+#define JAYD_FIRMWARE_HASH_H
+
+#include <Arduino.h>
+
+// 32-bit FNV-1a, used to key on-SD caches by track path
+inline uint32_t fnv1a(const char* data, uint32_t hash = 2166136261u){
+	while(*data){
+		hash ^= (uint8_t) *data++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+inline uint32_t fnv1a(const uint8_t* data, size_t size, uint32_t hash = 2166136261u){
+	for(size_t i = 0; i < size; i++){
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+#endif //JAYD_FIRMWARE_HASH_H
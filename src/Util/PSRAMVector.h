@@ -0,0 +1,119 @@
+#ifndef JAYD_FIRMWARE_PSRAMVECTOR_H
+#define JAYD_FIRMWARE_PSRAMVECTOR_H
+
+#include <Arduino.h>
+#include <algorithm>
+
+// Growable array of plain-data items in PSRAM, for tables that would otherwise eat the internal heap.
+// Items are moved with realloc, so T must be trivially copyable.
+template<typename T>
+class PSRAMVector {
+public:
+	PSRAMVector() = default;
+	PSRAMVector(const PSRAMVector&) = delete;
+	PSRAMVector& operator=(const PSRAMVector&) = delete;
+
+	~PSRAMVector(){
+		free(items);
+	}
+
+	bool push_back(const T& item){
+		if(count == capacity && !reserve(capacity == 0 ? 64 : capacity * 2)) return false;
+
+		items[count++] = item;
+		return true;
+	}
+
+	// Appends count items in one go, returns the index of the first one or -1 if out of memory
+	int32_t append(const T* data, size_t count){
+		if(this->count + count > capacity && !reserve(max(this->count + count, capacity * 2))) return -1;
+
+		memcpy(items + this->count, data, count * sizeof(T));
+		this->count += count;
+		return this->count - count;
+	}
+
+	bool reserve(size_t size){
+		if(size <= capacity) return true;
+
+		T* grown = static_cast<T*>(ps_realloc(items, size * sizeof(T)));
+		if(grown == nullptr){
+			Serial.printf("ERROR: PSRAMVector couldn't grow to %u items\n", size);
+			return false;
+		}
+
+		items = grown;
+		capacity = size;
+		return true;
+	}
+
+	bool resize(size_t size){
+		if(!reserve(size)) return false;
+		count = size;
+		return true;
+	}
+
+	void clear(){
+		count = 0;
+	}
+
+	// Drops the allocation too, clear() keeps it for the next fill
+	void release(){
+		free(items);
+		items = nullptr;
+		count = capacity = 0;
+	}
+
+	void swap(PSRAMVector& other){
+		std::swap(items, other.items);
+		std::swap(count, other.count);
+		std::swap(capacity, other.capacity);
+	}
+
+	size_t size() const{
+		return count;
+	}
+
+	bool empty() const{
+		return count == 0;
+	}
+
+	T* data(){
+		return items;
+	}
+
+	const T* data() const{
+		return items;
+	}
+
+	T& operator[](size_t index){
+		return items[index];
+	}
+
+	const T& operator[](size_t index) const{
+		return items[index];
+	}
+
+	T* begin(){
+		return items;
+	}
+
+	T* end(){
+		return items + count;
+	}
+
+	const T* begin() const{
+		return items;
+	}
+
+	const T* end() const{
+		return items + count;
+	}
+
+private:
+	T* items = nullptr;
+	size_t count = 0;
+	size_t capacity = 0;
+};
+
+#endif //JAYD_FIRMWARE_PSRAMVECTOR_H
@@ -0,0 +1,94 @@
+#include "Timeline.h"
+#include <Loop/LoopManager.h>
+
+Timeline::Timeline(const char* name) : name(name){
+
+}
+
+Timeline::~Timeline(){
+	if(active){
+		LoopManager::removeListener(this);
+	}
+}
+
+Timeline& Timeline::then(const char* label, uint32_t delayMs, std::function<void()> action){
+	steps.push_back({ label, delayMs, action });
+
+	if(!active){
+		active = true;
+		reports.clear();
+		stepStart = micros();
+		LoopManager::addListener(this);
+	}
+
+	return *this;
+}
+
+void Timeline::finish(){
+	while(!steps.empty()){
+		runNext(micros() - stepStart);
+	}
+
+	idle();
+}
+
+void Timeline::clear(){
+	if(!steps.empty()){
+		Serial.printf("Timeline %s: dropped %d steps\n", name, steps.size());
+	}
+
+	steps.clear();
+	idle();
+}
+
+bool Timeline::isBusy() const{
+	return !steps.empty();
+}
+
+const std::vector<Timeline::Report>& Timeline::getReports() const{
+	return reports;
+}
+
+void Timeline::loop(uint micros){
+	if(steps.empty()){
+		idle();
+		return;
+	}
+
+	uint32_t waited = ::micros() - stepStart;
+	if(waited < steps.front().delayMs * 1000) return;
+
+	runNext(waited);
+
+	if(steps.empty()){
+		idle();
+	}
+}
+
+void Timeline::runNext(uint32_t waited){
+	// Pop before running, the action may queue further steps or finish() the timeline
+	Step step = steps.front();
+	steps.pop_front();
+
+	uint32_t runStart = micros();
+	if(step.action){
+		step.action();
+	}
+	uint32_t ran = micros() - runStart;
+
+	reports.push_back({ step.label, step.delayMs, waited, ran });
+	stepStart = micros();
+}
+
+void Timeline::idle(){
+	if(!active) return;
+	active = false;
+	LoopManager::removeListener(this);
+
+	if(reports.empty()) return;
+
+	Serial.printf("Timeline %s:\n", name);
+	for(const auto& report : reports){
+		Serial.printf("  %-16s planned %4u ms, waited %6u us, ran %6u us\n", report.label, report.plannedMs, report.waitedUs, report.ranUs);
+	}
+}
@@ -0,0 +1,59 @@
+#ifndef JAYD_FIRMWARE_TIMELINE_H
+#define JAYD_FIRMWARE_TIMELINE_H
+
+#include <Arduino.h>
+#include <Loop/LoopListener.h>
+#include <functional>
+#include <deque>
+#include <vector>
+
+// Cooperative replacement for delay() chains. Steps run one after another from the LoopManager,
+// each after waiting its own delay measured from the end of the previous step, so input, VU meters
+// and drawing keep running in between. When the queue runs empty the planned and actual wait and
+// run time of every step is printed to serial.
+class Timeline : public LoopListener {
+public:
+	explicit Timeline(const char* name);
+	virtual ~Timeline();
+
+	// Appends a step that runs delayMs after the previous one has finished
+	Timeline& then(const char* label, uint32_t delayMs, std::function<void()> action);
+
+	// Runs all pending steps right away, without waiting
+	void finish();
+
+	// Drops all pending steps
+	void clear();
+
+	bool isBusy() const;
+
+	void loop(uint micros) override;
+
+	struct Report {
+		const char* label;
+		uint32_t plannedMs;
+		uint32_t waitedUs;
+		uint32_t ranUs;
+	};
+
+	const std::vector<Report>& getReports() const;
+
+private:
+	struct Step {
+		const char* label;
+		uint32_t delayMs;
+		std::function<void()> action;
+	};
+
+	const char* name;
+	std::deque<Step> steps;
+	std::vector<Report> reports;
+
+	uint32_t stepStart = 0;
+	bool active = false;
+
+	void runNext(uint32_t waited);
+	void idle();
+};
+
+#endif //JAYD_FIRMWARE_TIMELINE_H